@@ -0,0 +1,711 @@
+/*
+ * Scanline rasterizer for the setpoint dial.
+ *
+ * Geometry is held in Q8 pixels. Every edge's coverage comes from an approximate signed distance, which is exact
+ * to within a tiny fraction of a pixel inside the one-pixel anti-aliasing band:
+ *
+ *   circle:     sd ~= (R^2 - d^2) / 2R   (d^2 stepped incrementally, one multiply per edge pixel)
+ *   half-plane: sd  = cross(u, p)        (linear in x, one add per pixel)
+ *
+ * Coverage is clamp(sd + 1/2, 0, 1). Each row is first reduced to the x-intervals where some coverage can exist
+ * (outer circle minus inner hole, intersected with the angular wedge, plus the cap discs), and only those are
+ * visited.
+ *
+ * Shapes meeting inside one pixel can't be combined by taking the larger coverage without leaving seams where
+ * they abut. The caps only contribute their part outside the wedge, which is disjoint from the body, so the two
+ * add. Where both cap discs' edges cross a pixel, their union is estimated from the angle between the edges.
+ */
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "dial_raster.h"
+
+#define Q8_ONE 256
+#define Q8_HALF 128
+#define DIR_SHIFT 12          // Unit vectors are Q12; cross products are therefore Q20
+#define RECIP_SHIFT 24
+#define EDGE_HALF (Q8_HALF << DIR_SHIFT)
+
+#define MAX_BODY_SPANS 4
+#define MAX_ROW_SPANS (MAX_BODY_SPANS + 2)
+
+typedef struct {
+    int lo; // Inclusive
+    int hi; // Exclusive
+} span_t;
+
+// A circle's anti-aliasing band, expressed on squared distance so the fully inside/outside tests need no sqrt
+typedef struct {
+    int32_t cx;
+    int32_t cy;
+    int32_t r;
+    int64_t r2;
+    int64_t in2;  // d^2 at or below this is fully inside
+    int64_t out2; // d^2 at or above this is fully outside
+    int32_t recip;
+} circle_t;
+
+typedef struct {
+    int32_t ux; // Q12
+    int32_t uy;
+} edge_t;
+
+typedef struct {
+    circle_t outer;
+    circle_t inner;
+    bool has_hole;
+    bool has_body;
+    bool has_wedge;
+    bool wedge_union; // Sweep > 180: the wedge is the union of the two half-planes rather than the intersection
+    int32_t wedge_mix; // (1 - cos) / 2 of the angle between the edge normals, Q8; see overlap_union()
+    edge_t e0;        // Inside when cross(u0, p) >= 0
+    edge_t e1;        // Inside when cross(p, u1) >= 0
+    int num_caps;
+    circle_t caps[2];
+} arc_setup_t;
+
+typedef void (*span_cb_t)(void *ctx, int y, int x, int n, const uint8_t *cov);
+
+static inline int32_t to_q8(float v)
+{
+    return (int32_t)lrintf(v * Q8_ONE);
+}
+
+static inline int64_t floor_div(int64_t a, int64_t b)
+{
+    int64_t q = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0))) {
+        q--;
+    }
+    return q;
+}
+
+static inline int64_t ceil_div(int64_t a, int64_t b)
+{
+    return -floor_div(-a, b);
+}
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t res = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (v >= res + bit) {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)res;
+}
+
+static inline uint8_t mul255(uint32_t a, uint32_t b)
+{
+    uint32_t t = a * b + 128;
+    return (uint8_t)((t + (t >> 8)) >> 8);
+}
+
+static inline uint8_t sd_to_cov(int32_t sd_q8)
+{
+    int32_t c = sd_q8 + Q8_HALF;
+    return c <= 0 ? 0 : c >= 255 ? 255 : (uint8_t)c;
+}
+
+// Coverage of a half-plane at signed distance s, Q20
+static inline uint8_t edge_cov(int32_t s)
+{
+    return s >= EDGE_HALF ? 255 : sd_to_cov(s >> DIR_SHIFT);
+}
+
+// Coverage of the union of two shapes whose edges both cross the pixel: the larger plus mix_q8 / 256 of the
+// smaller, mix being (1 - cos) / 2 of the angle between the edge normals. That is the max for coincident edges, the
+// (saturating) sum for edges facing each other and 3/4 of a pixel for two halves crossing at right angles.
+static inline uint8_t overlap_union(uint8_t a, uint8_t b, int32_t mix_q8)
+{
+    uint32_t hi = a > b ? a : b;
+    uint32_t lo = a > b ? b : a;
+    uint32_t u = hi + ((lo * (uint32_t)mix_q8) >> 8);
+    return u > 255 ? 255 : (uint8_t)u;
+}
+
+static inline uint8_t wedge_cov(const arc_setup_t *s, int32_t s0, int32_t s1)
+{
+    uint8_t c0 = edge_cov(s0);
+    uint8_t c1 = edge_cov(s1);
+    if (c0 == 255 || c1 == 255 || !c0 || !c1) {
+        // At most one edge crosses the pixel, where min/max are exact
+        return s->wedge_union ? (c0 > c1 ? c0 : c1) : (c0 < c1 ? c0 : c1);
+    }
+    uint8_t u = overlap_union(c0, c1, s->wedge_mix);
+    return s->wedge_union ? u : (uint8_t)(c0 + c1 - u);
+}
+
+static void circle_init(circle_t *c, int32_t cx, int32_t cy, int32_t r)
+{
+    c->cx = cx;
+    c->cy = cy;
+    c->r = r;
+    c->r2 = (int64_t)r * r;
+    c->in2 = r > Q8_HALF ? (int64_t)(r - Q8_HALF) * (r - Q8_HALF) : -1;
+    c->out2 = (int64_t)(r + Q8_HALF) * (r + Q8_HALF);
+    c->recip = r > 0 ? (int32_t)((1LL << RECIP_SHIFT) / (2 * r)) : 0;
+}
+
+// Coverage of a disc's interior for a pixel whose center is at squared distance d2
+static inline uint8_t circle_cov(const circle_t *c, int64_t d2)
+{
+    if (d2 <= c->in2) {
+        return 255;
+    }
+    if (d2 >= c->out2) {
+        return 0;
+    }
+    int32_t e = (int32_t)(c->r2 - d2);
+    return sd_to_cov((int32_t)(((int64_t)e * c->recip) >> RECIP_SHIFT));
+}
+
+static inline int32_t pixel_center(int i)
+{
+    return i * Q8_ONE + Q8_HALF;
+}
+
+// Pixels x with |center - cx| < hw, i.e. (cx - hw - 1/2, cx + hw - 1/2) in pixel units
+static inline span_t span_around(int32_t cx, int32_t hw)
+{
+    span_t s = {
+        .lo = (int)floor_div((int64_t)cx - hw - Q8_HALF, Q8_ONE) + 1,
+        .hi = (int)ceil_div((int64_t)cx + hw - Q8_HALF, Q8_ONE),
+    };
+    return s;
+}
+
+// Pixels in this row that may have non-zero coverage from the disc
+static bool circle_row_span(const circle_t *c, int32_t py, span_t *out)
+{
+    int64_t dy = py - c->cy;
+    int64_t rem = c->out2 - dy * dy;
+    if (rem <= 0) {
+        return false;
+    }
+    *out = span_around(c->cx, (int32_t)isqrt64((uint64_t)rem) + 1);
+    return out->lo < out->hi;
+}
+
+// Pixels in this row with zero coverage because they are well inside the hole
+static bool hole_row_span(const circle_t *c, int32_t py, span_t *out)
+{
+    int64_t dy = py - c->cy;
+    int64_t rem = c->in2 - dy * dy;
+    if (c->in2 < 0 || rem <= 0) {
+        return false;
+    }
+    // Shrink by one so rounding in isqrt can only leave extra pixels in, never drop covered ones
+    int32_t hw = (int32_t)isqrt64((uint64_t)rem) - 1;
+    if (hw <= 0) {
+        return false;
+    }
+    *out = span_around(c->cx, hw);
+    return out->lo < out->hi;
+}
+
+// s(x) = a + b * x, Q20. Pixels with s > -1/2 have some coverage.
+static span_t edge_row_span(int64_t a, int64_t b)
+{
+    span_t s = {.lo = INT_MIN, .hi = INT_MAX};
+    if (b > 0) {
+        s.lo = (int)floor_div(-EDGE_HALF - a, b) + 1;
+    } else if (b < 0) {
+        s.hi = (int)ceil_div(EDGE_HALF + a, -b);
+    } else if (a <= -EDGE_HALF) {
+        s.hi = s.lo;
+    }
+    return s;
+}
+
+static inline span_t span_intersect(span_t a, span_t b)
+{
+    span_t s = {.lo = a.lo > b.lo ? a.lo : b.lo, .hi = a.hi < b.hi ? a.hi : b.hi};
+    return s;
+}
+
+static inline void span_push(span_t *spans, int *count, span_t s)
+{
+    if (s.lo < s.hi) {
+        spans[(*count)++] = s;
+    }
+}
+
+static void span_sort_merge(span_t *spans, int *count)
+{
+    for (int i = 1; i < *count; i++) {
+        span_t s = spans[i];
+        int j = i - 1;
+        while (j >= 0 && spans[j].lo > s.lo) {
+            spans[j + 1] = spans[j];
+            j--;
+        }
+        spans[j + 1] = s;
+    }
+    int n = 0;
+    for (int i = 0; i < *count; i++) {
+        if (n > 0 && spans[i].lo <= spans[n - 1].hi) {
+            if (spans[i].hi > spans[n - 1].hi) {
+                spans[n - 1].hi = spans[i].hi;
+            }
+        } else {
+            spans[n++] = spans[i];
+        }
+    }
+    *count = n;
+}
+
+static void arc_setup(arc_setup_t *s, const dial_arc_t *arc)
+{
+    assert(arc->r_outer >= arc->r_inner && arc->r_inner >= 0);
+    assert(arc->r_outer <= DIAL_RASTER_MAX_RADIUS);
+
+    memset(s, 0, sizeof(*s));
+    int32_t cx = to_q8(arc->cx);
+    int32_t cy = to_q8(arc->cy);
+    circle_init(&s->outer, cx, cy, to_q8(arc->r_outer));
+    circle_init(&s->inner, cx, cy, to_q8(arc->r_inner));
+    s->has_hole = s->inner.r > Q8_HALF;
+
+    float sweep = arc->sweep_deg;
+    if (sweep >= 360.0f) {
+        s->has_body = true;
+        return;
+    }
+    s->has_body = sweep > 0.0f;
+    s->has_wedge = true;
+    s->wedge_union = sweep > 180.0f;
+
+    float a0 = arc->start_deg * (float)M_PI / 180.0f;
+    float a1 = (arc->start_deg + (sweep > 0.0f ? sweep : 0.0f)) * (float)M_PI / 180.0f;
+    s->e0.ux = (int32_t)lrintf(cosf(a0) * (1 << DIR_SHIFT));
+    s->e0.uy = (int32_t)lrintf(sinf(a0) * (1 << DIR_SHIFT));
+    s->e1.ux = (int32_t)lrintf(cosf(a1) * (1 << DIR_SHIFT));
+    s->e1.uy = (int32_t)lrintf(sinf(a1) * (1 << DIR_SHIFT));
+    // The inward normals are u0 and u1 turned towards each other, so the angle between them is 180 - sweep
+    s->wedge_mix = (int32_t)lrintf((1.0f + cosf(a1 - a0)) * 0.5f * Q8_ONE);
+
+    if (arc->cap == DIAL_CAP_ROUND) {
+        float rm = (arc->r_outer + arc->r_inner) * 0.5f;
+        int32_t rc = to_q8((arc->r_outer - arc->r_inner) * 0.5f);
+        circle_init(&s->caps[0], to_q8(arc->cx + rm * cosf(a0)), to_q8(arc->cy + rm * sinf(a0)), rc);
+        circle_init(&s->caps[1], to_q8(arc->cx + rm * cosf(a1)), to_q8(arc->cy + rm * sinf(a1)), rc);
+        s->num_caps = 2;
+    }
+}
+
+static void body_row_spans(const arc_setup_t *s, int32_t py, span_t *spans, int *count)
+{
+    span_t outer;
+    if (!s->has_body || !circle_row_span(&s->outer, py, &outer)) {
+        return;
+    }
+
+    span_t ring[2];
+    int num_ring = 0;
+    span_t hole;
+    if (s->has_hole && hole_row_span(&s->inner, py, &hole)) {
+        span_push(ring, &num_ring, span_intersect(outer, (span_t){.lo = INT_MIN, .hi = hole.lo}));
+        span_push(ring, &num_ring, span_intersect(outer, (span_t){.lo = hole.hi, .hi = INT_MAX}));
+    } else {
+        ring[num_ring++] = outer;
+    }
+
+    if (!s->has_wedge) {
+        for (int i = 0; i < num_ring; i++) {
+            spans[(*count)++] = ring[i];
+        }
+        return;
+    }
+
+    int64_t dy = py - s->outer.cy;
+    int64_t dx0 = Q8_HALF - s->outer.cx;
+    span_t w0 = edge_row_span((int64_t)s->e0.ux * dy - (int64_t)s->e0.uy * dx0, -(int64_t)s->e0.uy * Q8_ONE);
+    span_t w1 = edge_row_span((int64_t)s->e1.uy * dx0 - (int64_t)s->e1.ux * dy, (int64_t)s->e1.uy * Q8_ONE);
+    span_t wedge[2];
+    int num_wedge = 0;
+    if (s->wedge_union) {
+        span_push(wedge, &num_wedge, w0);
+        span_push(wedge, &num_wedge, w1);
+    } else {
+        span_push(wedge, &num_wedge, span_intersect(w0, w1));
+    }
+
+    for (int i = 0; i < num_ring; i++) {
+        for (int j = 0; j < num_wedge; j++) {
+            span_push(spans, count, span_intersect(ring[i], wedge[j]));
+        }
+    }
+}
+
+static void body_fill(const arc_setup_t *s, int32_t py, int x, int n, uint8_t *cov)
+{
+    int32_t dx = pixel_center(x) - s->outer.cx;
+    int32_t dy = py - s->outer.cy;
+    int64_t d2 = (int64_t)dx * dx + (int64_t)dy * dy;
+
+    if (!s->has_wedge) {
+        for (int i = 0; i < n; i++) {
+            uint8_t c = circle_cov(&s->outer, d2);
+            if (c && s->has_hole) {
+                c = mul255(c, 255 - circle_cov(&s->inner, d2));
+            }
+            cov[i] = c;
+            d2 += 2 * (int64_t)dx * Q8_ONE + Q8_ONE * Q8_ONE;
+            dx += Q8_ONE;
+        }
+        return;
+    }
+
+    int32_t s0 = s->e0.ux * dy - s->e0.uy * dx;
+    int32_t s1 = s->e1.uy * dx - s->e1.ux * dy;
+    const int32_t step0 = -s->e0.uy * Q8_ONE;
+    const int32_t step1 = s->e1.uy * Q8_ONE;
+    for (int i = 0; i < n; i++) {
+        uint8_t c = circle_cov(&s->outer, d2);
+        if (c && s->has_hole) {
+            c = mul255(c, 255 - circle_cov(&s->inner, d2));
+        }
+        if (c) {
+            c = mul255(c, wedge_cov(s, s0, s1));
+        }
+        cov[i] = c;
+        d2 += 2 * (int64_t)dx * Q8_ONE + Q8_ONE * Q8_ONE;
+        dx += Q8_ONE;
+        s0 += step0;
+        s1 += step1;
+    }
+}
+
+// Adds the caps outside the wedge (the body already covers the inside)
+static void caps_add(const arc_setup_t *s, int32_t py, int x, int n, uint8_t *cov)
+{
+    const circle_t *c0 = &s->caps[0];
+    const circle_t *c1 = &s->caps[1];
+    int32_t dx0 = pixel_center(x) - c0->cx;
+    int32_t dy0 = py - c0->cy;
+    int32_t dx1 = pixel_center(x) - c1->cx;
+    int32_t dy1 = py - c1->cy;
+    int64_t d20 = (int64_t)dx0 * dx0 + (int64_t)dy0 * dy0;
+    int64_t d21 = (int64_t)dx1 * dx1 + (int64_t)dy1 * dy1;
+
+    // The wedge edges pass through the arc's centre
+    int32_t ax = pixel_center(x) - s->outer.cx;
+    int32_t ay = py - s->outer.cy;
+    int32_t s0 = s->e0.ux * ay - s->e0.uy * ax;
+    int32_t s1 = s->e1.uy * ax - s->e1.ux * ay;
+    const int32_t step0 = -s->e0.uy * Q8_ONE;
+    const int32_t step1 = s->e1.uy * Q8_ONE;
+
+    for (int i = 0; i < n; i++) {
+        uint8_t v0 = circle_cov(c0, d20);
+        uint8_t v1 = circle_cov(c1, d21);
+        if (v0 | v1) {
+            uint8_t outside = s->has_body ? 255 - wedge_cov(s, s0, s1) : 255;
+            // The disc edges cross the wedge edges, so take a product as body_fill() does for the ring
+            uint8_t p0 = mul255(v0, outside);
+            uint8_t p1 = mul255(v1, outside);
+            uint32_t v = p0 > p1 ? p0 : p1;
+            if (v0 != 255 && v1 != 255 && v0 && v1) {
+                // Both disc edges cross the pixel; the normals are about a radius long here
+                int64_t dot = (int64_t)dx0 * dx1 + (int64_t)dy0 * dy1;
+                int64_t cos_q8 = dot * Q8_ONE / (c0->r2 > 0 ? c0->r2 : 1);
+                cos_q8 = cos_q8 > Q8_ONE ? Q8_ONE : cos_q8 < -Q8_ONE ? -Q8_ONE : cos_q8;
+                v = overlap_union(p0, p1, (int32_t)(Q8_ONE - cos_q8) / 2);
+            }
+            v += cov[i];
+            cov[i] = v > 255 ? 255 : (uint8_t)v;
+        }
+        d20 += 2 * (int64_t)dx0 * Q8_ONE + Q8_ONE * Q8_ONE;
+        d21 += 2 * (int64_t)dx1 * Q8_ONE + Q8_ONE * Q8_ONE;
+        dx0 += Q8_ONE;
+        dx1 += Q8_ONE;
+        s0 += step0;
+        s1 += step1;
+    }
+}
+
+static void raster_rows(const dial_arc_t *arc, int width, int height, span_cb_t cb, void *ctx)
+{
+    arc_setup_t s;
+    arc_setup(&s, arc);
+
+    // Rows touched by the outer circle or either cap; rows that end up empty cost a few integer ops
+    int32_t top = s.outer.cy - s.outer.r - Q8_HALF;
+    int32_t bottom = s.outer.cy + s.outer.r + Q8_HALF;
+    for (int k = 0; k < s.num_caps; k++) {
+        int32_t t = s.caps[k].cy - s.caps[k].r - Q8_HALF;
+        int32_t b = s.caps[k].cy + s.caps[k].r + Q8_HALF;
+        top = t < top ? t : top;
+        bottom = b > bottom ? b : bottom;
+    }
+    int y0 = (int)floor_div(top, Q8_ONE);
+    int y1 = (int)ceil_div(bottom, Q8_ONE);
+    y0 = y0 < 0 ? 0 : y0;
+    y1 = y1 > height ? height : y1;
+
+    // cov[] only holds DIAL_RASTER_MAX_WIDTH pixels; anything wider is clipped rather than overrun
+    const span_t clip = {.lo = 0, .hi = width < DIAL_RASTER_MAX_WIDTH ? width : DIAL_RASTER_MAX_WIDTH};
+    uint8_t cov[DIAL_RASTER_MAX_WIDTH];
+    for (int y = y0; y < y1; y++) {
+        int32_t py = pixel_center(y);
+
+        span_t body[MAX_BODY_SPANS];
+        int num_body = 0;
+        body_row_spans(&s, py, body, &num_body);
+        span_t caps[2];
+        bool cap_hit[2] = {false, false};
+        for (int k = 0; k < s.num_caps; k++) {
+            cap_hit[k] = circle_row_span(&s.caps[k], py, &caps[k]);
+        }
+
+        span_t row[MAX_ROW_SPANS];
+        int num_row = 0;
+        for (int i = 0; i < num_body; i++) {
+            body[i] = span_intersect(body[i], clip);
+            span_push(row, &num_row, body[i]);
+        }
+        for (int k = 0; k < s.num_caps; k++) {
+            if (cap_hit[k]) {
+                caps[k] = span_intersect(caps[k], clip);
+                span_push(row, &num_row, caps[k]);
+            }
+        }
+        span_sort_merge(row, &num_row);
+
+        for (int r = 0; r < num_row; r++) {
+            span_t m = row[r];
+            int n = m.hi - m.lo;
+            memset(cov, 0, n);
+            for (int i = 0; i < num_body; i++) {
+                span_t b = span_intersect(body[i], m);
+                if (b.lo < b.hi) {
+                    body_fill(&s, py, b.lo, b.hi - b.lo, cov + (b.lo - m.lo));
+                }
+            }
+            // Both caps are evaluated together, over one span where theirs overlap
+            span_t cap_spans[2];
+            int num_cap_spans = 0;
+            for (int k = 0; k < s.num_caps; k++) {
+                if (cap_hit[k]) {
+                    span_push(cap_spans, &num_cap_spans, span_intersect(caps[k], m));
+                }
+            }
+            span_sort_merge(cap_spans, &num_cap_spans);
+            for (int k = 0; k < num_cap_spans; k++) {
+                span_t c = cap_spans[k];
+                caps_add(&s, py, c.lo, c.hi - c.lo, cov + (c.lo - m.lo));
+            }
+            cb(ctx, y, m.lo, n, cov);
+        }
+    }
+}
+
+static inline uint16_t blend565(uint16_t dst, uint16_t src, uint8_t a)
+{
+    // Spread to 0b00000gggggg00000rrrrr000000bbbbb so all three channels scale with one multiply
+    uint32_t a5 = (a + 4) >> 3;
+    uint32_t s = (src | ((uint32_t)src << 16)) & 0x07E0F81F;
+    uint32_t d = (dst | ((uint32_t)dst << 16)) & 0x07E0F81F;
+    d = (d + (((s - d) * a5) >> 5)) & 0x07E0F81F;
+    return (uint16_t)(d | (d >> 16));
+}
+
+// Fixed-point atan2 in Q16 turns, clockwise from +x with y pointing down. Max error is about 0.25 degrees.
+static uint16_t atan2_turns(int32_t y, int32_t x)
+{
+    uint32_t ax = x < 0 ? -(uint32_t)x : (uint32_t)x;
+    uint32_t ay = y < 0 ? -(uint32_t)y : (uint32_t)y;
+    uint32_t hi = ax > ay ? ax : ay;
+    uint32_t lo = ax > ay ? ay : ax;
+    if (hi == 0) {
+        return 0;
+    }
+    // Bring hi under 2^16 so lo << 15 fits a 32-bit divide (a 64-bit one is a libgcc call on Xtensa)
+    int shift = 16 - __builtin_clz(hi);
+    if (shift > 0) {
+        hi >>= shift;
+        lo >>= shift;
+    }
+    // atan(z) / 2pi ~= z / 8 + 0.0435 * z * (1 - z), z in [0, 1]
+    uint32_t z = (lo << 15) / hi;
+    uint32_t t = (z >> 2) + (((z * (32768 - z)) >> 15) * 2848 >> 15);
+    if (ay > ax) {
+        t = 16384 - t;
+    }
+    if (x < 0) {
+        t = 32768 - t;
+    }
+    if (y < 0) {
+        t = 65536 - t;
+    }
+    return (uint16_t)t;
+}
+
+static inline uint8_t conic_index(const dial_paint_t *p, int x, int y)
+{
+    uint16_t a = atan2_turns(pixel_center(y) - p->gcy, pixel_center(x) - p->gcx);
+    uint32_t rel = (uint16_t)(a - p->start);
+    if (rel > p->sweep) {
+        return rel - p->sweep < (65536 - p->sweep) / 2 ? 255 : 0;
+    }
+    return (uint8_t)((rel * p->sweep_inv) >> 16);
+}
+
+static void blend_span(dial_surface_t *dst, const dial_paint_t *paint, int y, int x, int n, const uint8_t *cov)
+{
+    uint16_t *px = dst->pixels + (size_t)y * dst->stride + x;
+    switch (paint->type) {
+    case DIAL_PAINT_SOLID:
+        for (int i = 0; i < n; i++) {
+            uint8_t a = cov[i];
+            if (a == 255) {
+                px[i] = paint->color;
+            } else if (a) {
+                px[i] = blend565(px[i], paint->color, a);
+            }
+        }
+        break;
+    case DIAL_PAINT_LINEAR: {
+        int32_t t = paint->t0 + paint->tx * x + paint->ty * y;
+        for (int i = 0; i < n; i++, t += paint->tx) {
+            uint8_t a = cov[i];
+            if (a) {
+                int32_t idx = t >> 8;
+                uint16_t c = paint->lut[idx < 0 ? 0 : idx > 255 ? 255 : idx];
+                px[i] = a == 255 ? c : blend565(px[i], c, a);
+            }
+        }
+        break;
+    }
+    case DIAL_PAINT_CONIC:
+        for (int i = 0; i < n; i++) {
+            uint8_t a = cov[i];
+            if (a) {
+                uint16_t c = paint->lut[conic_index(paint, x + i, y)];
+                px[i] = a == 255 ? c : blend565(px[i], c, a);
+            }
+        }
+        break;
+    }
+}
+
+static void build_ramp(uint16_t *lut, uint16_t c0, uint16_t c1)
+{
+    int r0 = c0 >> 11, g0 = (c0 >> 5) & 0x3F, b0 = c0 & 0x1F;
+    int r1 = c1 >> 11, g1 = (c1 >> 5) & 0x3F, b1 = c1 & 0x1F;
+    for (int i = 0; i < 256; i++) {
+        int r = (r0 * (255 - i) + r1 * i + 127) / 255;
+        int g = (g0 * (255 - i) + g1 * i + 127) / 255;
+        int b = (b0 * (255 - i) + b1 * i + 127) / 255;
+        lut[i] = (uint16_t)((r << 11) | (g << 5) | b);
+    }
+}
+
+void dial_paint_solid(dial_paint_t *paint, uint16_t color)
+{
+    memset(paint, 0, sizeof(*paint));
+    paint->type = DIAL_PAINT_SOLID;
+    paint->color = color;
+}
+
+void dial_paint_linear(dial_paint_t *paint, float x0, float y0, uint16_t c0, float x1, float y1, uint16_t c1)
+{
+    memset(paint, 0, sizeof(*paint));
+    paint->type = DIAL_PAINT_LINEAR;
+    build_ramp(paint->lut, c0, c1);
+
+    float dx = x1 - x0;
+    float dy = y1 - y0;
+    float len2 = dx * dx + dy * dy;
+    if (len2 < 1.0f) {
+        len2 = 1.0f;
+    }
+    // Ramp index, Q8, as a linear function of the pixel indices
+    float k = 255.0f * Q8_ONE / len2;
+    paint->tx = (int32_t)lrintf(dx * k);
+    paint->ty = (int32_t)lrintf(dy * k);
+    paint->t0 = (int32_t)lrintf(((0.5f - x0) * dx + (0.5f - y0) * dy) * k);
+}
+
+void dial_paint_conic(dial_paint_t *paint, float cx, float cy, float start_deg, float sweep_deg,
+                      uint16_t c0, uint16_t c1)
+{
+    memset(paint, 0, sizeof(*paint));
+    paint->type = DIAL_PAINT_CONIC;
+    build_ramp(paint->lut, c0, c1);
+
+    paint->gcx = to_q8(cx);
+    paint->gcy = to_q8(cy);
+    float start = fmodf(start_deg, 360.0f);
+    if (start < 0.0f) {
+        start += 360.0f;
+    }
+    paint->start = (uint32_t)lrintf(start / 360.0f * 65536.0f) & 0xFFFF;
+    float sweep = sweep_deg < 0.0f ? 0.0f : sweep_deg > 360.0f ? 360.0f : sweep_deg;
+    paint->sweep = (uint32_t)lrintf(sweep / 360.0f * 65535.0f);
+    if (paint->sweep == 0) {
+        paint->sweep = 1;
+    }
+    paint->sweep_inv = (255u << 16) / paint->sweep;
+}
+
+static void surface_span_cb(void *ctx, int y, int x, int n, const uint8_t *cov)
+{
+    void **args = ctx;
+    blend_span(args[0], args[1], y, x, n, cov);
+}
+
+void dial_raster_arc(dial_surface_t *dst, const dial_arc_t *arc, const dial_paint_t *paint)
+{
+    void *args[2] = {dst, (void *)paint};
+    raster_rows(arc, dst->width, dst->height, surface_span_cb, args);
+}
+
+typedef struct {
+    uint8_t *mask;
+    int stride;
+} mask_ctx_t;
+
+static void mask_span_cb(void *ctx, int y, int x, int n, const uint8_t *cov)
+{
+    mask_ctx_t *m = ctx;
+    uint8_t *row = m->mask + (size_t)y * m->stride + x;
+    for (int i = 0; i < n; i++) {
+        if (cov[i] > row[i]) {
+            row[i] = cov[i];
+        }
+    }
+}
+
+void dial_raster_arc_a8(uint8_t *mask, int width, int height, int stride, const dial_arc_t *arc)
+{
+    mask_ctx_t m = {.mask = mask, .stride = stride};
+    raster_rows(arc, width, height, mask_span_cb, &m);
+}
+
+void dial_blend_a8(dial_surface_t *dst, int x, int y, const uint8_t *mask, int width, int height, int stride,
+                   const dial_paint_t *paint)
+{
+    int mx0 = x < 0 ? -x : 0;
+    int my0 = y < 0 ? -y : 0;
+    int mx1 = dst->width - x < width ? dst->width - x : width;
+    int my1 = dst->height - y < height ? dst->height - y : height;
+    for (int my = my0; my < my1; my++) {
+        if (mx0 < mx1) {
+            blend_span(dst, paint, y + my, x + mx0, mx1 - mx0, mask + (size_t)my * stride + mx0);
+        }
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Widest surface (or mask) row the rasterizer will touch; columns beyond it are clipped
+#define DIAL_RASTER_MAX_WIDTH 512
+// Largest supported outer radius, in pixels. Keeps the per-pixel fixed-point state in 32 bits.
+#define DIAL_RASTER_MAX_RADIUS 1024
+
+#define DIAL_RGB565(r, g, b) ((uint16_t)((((r) & 0xF8) << 8) | (((g) & 0xFC) << 3) | ((b) >> 3)))
+
+/**
+ * @brief How the ends of a partial arc are finished
+ */
+typedef enum {
+    DIAL_CAP_FLAT,  /*!< Cut along the radius at the start/end angle */
+    DIAL_CAP_ROUND, /*!< Half-disc extending past the start/end angle */
+} dial_cap_t;
+
+typedef enum {
+    DIAL_PAINT_SOLID,
+    DIAL_PAINT_LINEAR, /*!< Two-stop gradient along a line */
+    DIAL_PAINT_CONIC,  /*!< Two-stop gradient following the angle around a center */
+} dial_paint_type_t;
+
+/**
+ * @brief Ring segment description
+ *
+ * Coordinates are in pixels, with pixel (x, y) covering [x, x + 1) x [y, y + 1). Angles are in degrees,
+ * 0 pointing right and increasing clockwise on screen (y grows downwards).
+ */
+typedef struct {
+    float cx;
+    float cy;
+    float r_inner;   /*!< 0 for a filled disc/pie */
+    float r_outer;
+    float start_deg;
+    float sweep_deg; /*!< Clockwise extent, 0..360. >= 360 draws a full ring with no caps */
+    dial_cap_t cap;
+} dial_arc_t;
+
+/**
+ * @brief Colour source for blending coverage into a surface
+ *
+ * Build with one of the dial_paint_*() initializers; gradients are resolved to a 256-entry lookup table once,
+ * so nothing but integer maths happens per pixel.
+ */
+typedef struct {
+    dial_paint_type_t type;
+    uint16_t color;     /*!< DIAL_PAINT_SOLID */
+    int32_t t0;         /*!< DIAL_PAINT_LINEAR: ramp index at pixel (0, 0), Q8 */
+    int32_t tx;         /*!< DIAL_PAINT_LINEAR: ramp index step per pixel in x, Q8 */
+    int32_t ty;         /*!< DIAL_PAINT_LINEAR: ramp index step per pixel in y, Q8 */
+    int32_t gcx;        /*!< DIAL_PAINT_CONIC: center, Q8 */
+    int32_t gcy;
+    uint32_t start;     /*!< DIAL_PAINT_CONIC: start angle, Q16 turns */
+    uint32_t sweep;     /*!< DIAL_PAINT_CONIC: extent, Q16 turns */
+    uint32_t sweep_inv; /*!< DIAL_PAINT_CONIC: (255 << 16) / sweep */
+    uint16_t lut[256];
+} dial_paint_t;
+
+/**
+ * @brief RGB565 render target
+ */
+typedef struct {
+    uint16_t *pixels;
+    int width;
+    int height;
+    int stride; /*!< Row pitch, in pixels */
+} dial_surface_t;
+
+void dial_paint_solid(dial_paint_t *paint, uint16_t color);
+
+/**
+ * @brief Gradient from c0 at (x0, y0) to c1 at (x1, y1), clamped beyond both ends
+ */
+void dial_paint_linear(dial_paint_t *paint, float x0, float y0, uint16_t c0, float x1, float y1, uint16_t c1);
+
+/**
+ * @brief Gradient from c0 at start_deg to c1 at start_deg + sweep_deg around (cx, cy)
+ *
+ * Outside the sweep, each half of the remaining gap takes the colour of the nearer end, so round caps pick up the
+ * end colours.
+ */
+void dial_paint_conic(dial_paint_t *paint, float cx, float cy, float start_deg, float sweep_deg,
+                      uint16_t c0, uint16_t c1);
+
+/**
+ * @brief Rasterize an anti-aliased arc and blend it straight into an RGB565 surface
+ *
+ * Only the pixels inside each row's coverage spans are visited. Coverage stays within about 6% of the exact pixel
+ * area, including where the caps meet across a nearly closed ring. It is cruder where three or more edges cross
+ * one pixel (the centre of a round-capped pie) and for rings or holes thinner than a pixel.
+ */
+void dial_raster_arc(dial_surface_t *dst, const dial_arc_t *arc, const dial_paint_t *paint);
+
+/**
+ * @brief Rasterize an anti-aliased arc into an A8 coverage mask
+ *
+ * Coverage is max-combined with what is already in the mask, so several arcs can be accumulated before a single
+ * dial_blend_a8() pass. Arc coordinates are relative to the mask origin.
+ */
+void dial_raster_arc_a8(uint8_t *mask, int width, int height, int stride, const dial_arc_t *arc);
+
+/**
+ * @brief Blend an A8 coverage mask into an RGB565 surface with its top-left corner at (x, y)
+ *
+ * The paint is evaluated in surface coordinates. The mask is clipped against the surface.
+ */
+void dial_blend_a8(dial_surface_t *dst, int x, int y, const uint8_t *mask, int width, int height, int stride,
+                   const dial_paint_t *paint);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,17 @@
+#include <stdlib.h>
+
+#include "sdkconfig.h"
+#include "unity.h"
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    int failures = UNITY_END();
+#if CONFIG_IDF_TARGET_LINUX
+    // The test binary's exit status is the result
+    exit(failures);
+#else
+    (void)failures;
+#endif
+}
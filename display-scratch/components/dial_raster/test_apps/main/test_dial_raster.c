@@ -0,0 +1,372 @@
+/*
+ * Golden-image tests and throughput benchmark for the dial rasterizer.
+ *
+ * Every arc is rasterized into an A8 mask and, with solid white over black, into an RGB565 surface. Both are
+ * compared pixel by pixel against a 16x16 supersampled, double-precision rendering of the same shape. Paints and
+ * dial_blend_a8() are checked against closed-form colours and against dial_raster_arc().
+ */
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "unity.h"
+
+#include "dial_raster.h"
+
+#define W 256
+#define H 256
+#define SUPERSAMPLE 16
+
+// Distance-based coverage against box-filtered area: edges at 45 degrees are the worst case
+#define A8_MAX_ERR 24
+#define A8_MEAN_ERR 6.0
+// The mean only says something about bias once there are enough edge pixels to average over
+#define A8_MEAN_MIN_PIXELS 64
+// RGB565 adds 5-bit alpha and 5/6-bit channel quantization on top
+#define RGB_MAX_ERR (A8_MAX_ERR + 16)
+
+#define BACKGROUND DIAL_RGB565(24, 28, 24)
+
+typedef struct {
+    const char *name;
+    dial_arc_t arc;
+} golden_case_t;
+
+static const golden_case_t s_cases[] = {
+    {"round caps, sweep > 180", {128.3f, 128.7f, 90, 110, 135, 270, DIAL_CAP_ROUND}},
+    {"flat caps, sweep > 180", {128, 128, 90, 110, 135, 270, DIAL_CAP_FLAT}},
+    {"flat caps, sweep <= 180", {128, 128, 60, 61.5f, 10, 60, DIAL_CAP_FLAT}},
+    {"round caps, sweep <= 180", {127.5f, 130.25f, 40, 80, 200, 120, DIAL_CAP_ROUND}},
+    {"sweep exactly 180", {128, 128, 40, 80, -45, 180, DIAL_CAP_FLAT}},
+    {"full ring", {128, 128, 70, 120, 0, 360, DIAL_CAP_ROUND}},
+    {"sweep beyond 360", {128.5f, 127.1f, 30, 50, 77, 400, DIAL_CAP_FLAT}},
+    {"filled pie", {100.2f, 140.9f, 0, 50, -30, 90, DIAL_CAP_FLAT}},
+    {"1px disc", {64.5f, 64.5f, 0, 0.5f, 0, 360, DIAL_CAP_FLAT}},
+    {"zero sweep dot", {128, 128, 100, 116, 300, 0, DIAL_CAP_ROUND}},
+    {"centre off surface", {-20, 150, 100, 140, -90, 180, DIAL_CAP_ROUND}},
+    // The caps nearly touch across the gap, so their edges meet face to face inside single pixels
+    {"round caps, sweep near 360", {48.42f, 42.65f, 87.17f, 113.64f, -376.34f, 345.08f, DIAL_CAP_ROUND}},
+};
+
+static uint8_t s_mask[H * W];
+static uint16_t s_pixels[H * W];
+static uint16_t s_expect[H * W];
+static double s_ref[H * W];
+
+static void check(bool ok, const char *fmt, ...)
+{
+    char msg[128];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, args);
+    va_end(args);
+    TEST_ASSERT_MESSAGE(ok, msg);
+}
+
+static bool ref_inside(const dial_arc_t *a, double px, double py)
+{
+    double sweep = a->sweep_deg;
+    double dx = px - a->cx;
+    double dy = py - a->cy;
+    double d = sqrt(dx * dx + dy * dy);
+    if (d >= a->r_inner && d <= a->r_outer && sweep > 0) {
+        if (sweep >= 360) {
+            return true;
+        }
+        double t = fmod(atan2(dy, dx) * 180 / M_PI - a->start_deg, 360);
+        if ((t < 0 ? t + 360 : t) <= sweep) {
+            return true;
+        }
+    }
+    if (a->cap == DIAL_CAP_ROUND && sweep < 360) {
+        double rm = (a->r_outer + a->r_inner) / 2;
+        double rc = (a->r_outer - a->r_inner) / 2;
+        double ends[2] = {a->start_deg, a->start_deg + (sweep > 0 ? sweep : 0)};
+        for (int k = 0; k < 2; k++) {
+            double qx = dx - rm * cos(ends[k] * M_PI / 180);
+            double qy = dy - rm * sin(ends[k] * M_PI / 180);
+            if (qx * qx + qy * qy <= rc * rc) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void render_reference(const dial_arc_t *a)
+{
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            // Everything lives in the annulus, caps included; skip the supersampling elsewhere
+            double dx = x + 0.5 - a->cx;
+            double dy = y + 0.5 - a->cy;
+            double d = sqrt(dx * dx + dy * dy);
+            if (d > a->r_outer + 1 || d < a->r_inner - 1) {
+                s_ref[y * W + x] = 0;
+                continue;
+            }
+            int hits = 0;
+            for (int j = 0; j < SUPERSAMPLE; j++) {
+                for (int i = 0; i < SUPERSAMPLE; i++) {
+                    hits += ref_inside(a, x + (i + 0.5) / SUPERSAMPLE, y + (j + 0.5) / SUPERSAMPLE);
+                }
+            }
+            s_ref[y * W + x] = hits * 255.0 / (SUPERSAMPLE * SUPERSAMPLE);
+        }
+    }
+}
+
+static void check_golden(const golden_case_t *gc)
+{
+    render_reference(&gc->arc);
+
+    memset(s_mask, 0, sizeof(s_mask));
+    dial_raster_arc_a8(s_mask, W, H, W, &gc->arc);
+
+    memset(s_pixels, 0, sizeof(s_pixels));
+    dial_surface_t surface = {.pixels = s_pixels, .width = W, .height = H, .stride = W};
+    dial_paint_t white;
+    dial_paint_solid(&white, 0xFFFF);
+    dial_raster_arc(&surface, &gc->arc, &white);
+
+    double a8_max = 0, rgb_max = 0, a8_sum = 0, ref_area = 0;
+    int touched = 0;
+    for (int i = 0; i < W * H; i++) {
+        double ref = s_ref[i];
+        double a8_err = fabs(s_mask[i] - ref);
+        uint16_t c = s_pixels[i];
+        double chans[3] = {(c >> 11) * 255.0 / 31, ((c >> 5) & 0x3F) * 255.0 / 63, (c & 0x1F) * 255.0 / 31};
+        for (int k = 0; k < 3; k++) {
+            rgb_max = fmax(rgb_max, fabs(chans[k] - ref));
+        }
+        a8_max = fmax(a8_max, a8_err);
+        ref_area += ref;
+        if (ref > 0 || s_mask[i]) {
+            a8_sum += a8_err;
+            touched++;
+        }
+    }
+    double a8_mean = touched ? a8_sum / touched : 0;
+    printf("%-28s a8 max %4.1f mean %5.2f, rgb565 max %4.1f over %d px\n", gc->name, a8_max, a8_mean, rgb_max,
+           touched);
+    check(ref_area > 0, "%s: reference is empty", gc->name);
+    check(a8_max <= A8_MAX_ERR, "%s: a8 max error %.1f > %d", gc->name, a8_max, A8_MAX_ERR);
+    check(touched < A8_MEAN_MIN_PIXELS || a8_mean <= A8_MEAN_ERR, "%s: a8 mean error %.2f > %.1f", gc->name, a8_mean,
+          A8_MEAN_ERR);
+    check(rgb_max <= RGB_MAX_ERR, "%s: rgb565 max error %.1f > %d", gc->name, rgb_max, RGB_MAX_ERR);
+}
+
+TEST_CASE("arcs match supersampled reference", "[dial_raster]")
+{
+    for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+        check_golden(&s_cases[i]);
+    }
+}
+
+TEST_CASE("conic gradient end colours", "[dial_raster]")
+{
+    const dial_arc_t arc = {128, 128, 90, 110, 135, 270, DIAL_CAP_ROUND};
+    const uint16_t blue = DIAL_RGB565(0, 0, 255);
+    const uint16_t red = DIAL_RGB565(255, 0, 0);
+    dial_paint_t paint;
+    dial_paint_conic(&paint, 128, 128, 135, 270, blue, red);
+    memset(s_pixels, 0, sizeof(s_pixels));
+    dial_surface_t surface = {.pixels = s_pixels, .width = W, .height = H, .stride = W};
+    dial_raster_arc(&surface, &arc, &paint);
+
+    // Sample the middle of the ring just inside each end, in each cap, and halfway round
+    const struct {
+        float deg;
+        int min_r, max_r, min_b, max_b;
+    } samples[] = {
+        {137, 0, 2, 29, 31},
+        {130, 0, 0, 31, 31},
+        {43, 29, 31, 0, 2},
+        {50, 31, 31, 0, 0},
+        {270, 13, 18, 13, 18},
+    };
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        int x = (int)(128 + 100 * cosf(samples[i].deg * (float)M_PI / 180));
+        int y = (int)(128 + 100 * sinf(samples[i].deg * (float)M_PI / 180));
+        uint16_t c = s_pixels[y * W + x];
+        int r = c >> 11;
+        int b = c & 0x1F;
+        check(r >= samples[i].min_r && r <= samples[i].max_r && b >= samples[i].min_b && b <= samples[i].max_b,
+              "at %.0f deg got r=%d b=%d", samples[i].deg, r, b);
+    }
+}
+
+TEST_CASE("linear gradient ends, midpoint and clamping", "[dial_raster]")
+{
+    // Pixel centres (64, 100) to (192, 164), every channel moving
+    const float x0 = 64.5f, y0 = 100.5f, x1 = 192.5f, y1 = 164.5f;
+    const uint16_t c0 = DIAL_RGB565(248, 0, 64);
+    const uint16_t c1 = DIAL_RGB565(0, 252, 248);
+    dial_paint_t paint;
+    dial_paint_linear(&paint, x0, y0, c0, x1, y1, c1);
+
+    // A disc covering the whole surface, so every pixel shows the paint unblended
+    const dial_arc_t cover = {128, 128, 0, 200, 0, 360, DIAL_CAP_FLAT};
+    memset(s_pixels, 0, sizeof(s_pixels));
+    dial_surface_t surface = {.pixels = s_pixels, .width = W, .height = H, .stride = W};
+    dial_raster_arc(&surface, &cover, &paint);
+
+    TEST_ASSERT_EQUAL_HEX16(c0, s_pixels[100 * W + 64]);
+    TEST_ASSERT_EQUAL_HEX16(c1, s_pixels[164 * W + 192]);
+    // Beyond both ends, along the gradient and off to the side
+    TEST_ASSERT_EQUAL_HEX16(c0, s_pixels[0 * W + 0]);
+    TEST_ASSERT_EQUAL_HEX16(c0, s_pixels[140 * W + 30]);
+    TEST_ASSERT_EQUAL_HEX16(c1, s_pixels[255 * W + 255]);
+    TEST_ASSERT_EQUAL_HEX16(c1, s_pixels[120 * W + 250]);
+
+    const double dx = x1 - x0, dy = y1 - y0, len2 = dx * dx + dy * dy;
+    const int from[3] = {c0 >> 11, (c0 >> 5) & 0x3F, c0 & 0x1F};
+    const int to[3] = {c1 >> 11, (c1 >> 5) & 0x3F, c1 & 0x1F};
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            double t = ((x + 0.5 - x0) * dx + (y + 0.5 - y0) * dy) / len2;
+            t = t < 0 ? 0 : t > 1 ? 1 : t;
+            uint16_t c = s_pixels[y * W + x];
+            const int got[3] = {c >> 11, (c >> 5) & 0x3F, c & 0x1F};
+            for (int k = 0; k < 3; k++) {
+                double want = from[k] + (to[k] - from[k]) * t;
+                check(fabs(got[k] - want) <= 1.0, "(%d, %d) channel %d is %d, expected %.2f", x, y, k, got[k], want);
+            }
+        }
+    }
+    // Halfway, the 5-bit channels sit between two steps
+    uint16_t mid = s_pixels[132 * W + 128];
+    TEST_ASSERT_INT_WITHIN(1, 15, mid >> 11);
+    TEST_ASSERT_INT_WITHIN(1, 31, (mid >> 5) & 0x3F);
+}
+
+TEST_CASE("a8 blend matches direct raster and clips", "[dial_raster]")
+{
+    enum { MW = 120, MH = 100, SW = W - 16 };
+    static uint8_t mask[MH * MW];
+    const dial_arc_t arc = {60.25f, 50.5f, 30, 45, 200, 250, DIAL_CAP_ROUND};
+    memset(mask, 0, sizeof(mask));
+    dial_raster_arc_a8(mask, MW, MH, MW, &arc);
+
+    dial_paint_t paint;
+    dial_paint_linear(&paint, 0, 0, DIAL_RGB565(255, 160, 0), SW, H, DIAL_RGB565(40, 0, 255));
+
+    // The surfaces are narrower than their stride so writes past the right edge would show up
+    dial_surface_t blended = {.pixels = s_pixels, .width = SW, .height = H, .stride = W};
+    dial_surface_t direct = {.pixels = s_expect, .width = SW, .height = H, .stride = W};
+    const struct {
+        const char *name;
+        int x, y;
+        bool visible;
+    } offsets[] = {
+        {"inside", 40, 60, true},
+        {"negative", -37, -21, true},
+        {"past right and bottom", SW - 70, H - 40, true},
+        {"off the left", -MW, 10, false},
+        {"off the bottom", 30, H, false},
+    };
+    for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+        for (int p = 0; p < W * H; p++) {
+            s_pixels[p] = BACKGROUND;
+            s_expect[p] = BACKGROUND;
+        }
+        dial_blend_a8(&blended, offsets[i].x, offsets[i].y, mask, MW, MH, MW, &paint);
+        dial_arc_t moved = arc;
+        moved.cx += offsets[i].x;
+        moved.cy += offsets[i].y;
+        dial_raster_arc(&direct, &moved, &paint);
+
+        int differ = 0, drawn = 0, outside = 0;
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                uint16_t c = s_pixels[y * W + x];
+                differ += c != s_expect[y * W + x];
+                drawn += c != BACKGROUND;
+                outside += x >= SW && c != BACKGROUND;
+            }
+        }
+        check(differ == 0, "%s: %d pixels differ from dial_raster_arc", offsets[i].name, differ);
+        check(outside == 0, "%s: %d pixels written past the surface width", offsets[i].name, outside);
+        check(offsets[i].visible ? drawn > 0 : drawn == 0, "%s: %d pixels drawn", offsets[i].name, drawn);
+    }
+}
+
+TEST_CASE("surface wider than DIAL_RASTER_MAX_WIDTH is clipped", "[dial_raster]")
+{
+    enum { WIDE = DIAL_RASTER_MAX_WIDTH + 88, ROWS = 64 };
+    static uint8_t wide[ROWS * WIDE];
+    memset(wide, 0, sizeof(wide));
+    const dial_arc_t arc = {DIAL_RASTER_MAX_WIDTH, 32, 0, 40, 0, 360, DIAL_CAP_FLAT};
+    dial_raster_arc_a8(wide, WIDE, ROWS, WIDE, &arc);
+
+    int inside = 0, beyond = 0;
+    for (int y = 0; y < ROWS; y++) {
+        for (int x = 0; x < WIDE; x++) {
+            if (wide[y * WIDE + x]) {
+                x < DIAL_RASTER_MAX_WIDTH ? inside++ : beyond++;
+            }
+        }
+    }
+    check(inside > 0, "nothing drawn left of the limit");
+    check(beyond == 0, "%d pixels drawn past the limit", beyond);
+}
+
+// The benchmark draws the 270 degree setpoint ring on the 480x480 panel, nudged every iteration the way a drag would
+#define BENCH_W 480
+#define BENCH_H 480
+#define BENCH_ITERATIONS 2000
+
+static uint16_t s_bench_pixels[BENCH_H * BENCH_W];
+static uint8_t s_bench_mask[BENCH_H * BENCH_W];
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void bench(const char *name, const dial_arc_t *base, const dial_paint_t *paint)
+{
+    dial_surface_t surface = {.pixels = s_bench_pixels, .width = BENCH_W, .height = BENCH_H, .stride = BENCH_W};
+    dial_arc_t arc = *base;
+
+    memset(s_bench_mask, 0, sizeof(s_bench_mask));
+    dial_raster_arc_a8(s_bench_mask, BENCH_W, BENCH_H, BENCH_W, &arc);
+    long pixels = 0;
+    for (int i = 0; i < BENCH_W * BENCH_H; i++) {
+        pixels += s_bench_mask[i] != 0;
+    }
+
+    double start = now_ms();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        arc.start_deg = base->start_deg + (i % 16) * 0.1f;
+        if (paint) {
+            dial_raster_arc(&surface, &arc, paint);
+        } else {
+            dial_raster_arc_a8(s_bench_mask, BENCH_W, BENCH_H, BENCH_W, &arc);
+        }
+    }
+    double elapsed = now_ms() - start;
+    printf("%-14s %8ld px/arc %10.0f px/ms %8.3f ms/arc\n", name, pixels, pixels * BENCH_ITERATIONS / elapsed,
+           elapsed / BENCH_ITERATIONS);
+}
+
+TEST_CASE("throughput", "[dial_raster][bench]")
+{
+    const dial_arc_t ring = {240, 240, 200, 224, 135, 270, DIAL_CAP_ROUND};
+    const dial_arc_t knob = {240, 240, 0, 150, 0, 360, DIAL_CAP_FLAT};
+    dial_paint_t solid, linear, conic;
+    dial_paint_solid(&solid, DIAL_RGB565(255, 128, 0));
+    dial_paint_linear(&linear, 16, 240, DIAL_RGB565(0, 0, 255), 464, 240, DIAL_RGB565(255, 0, 0));
+    dial_paint_conic(&conic, 240, 240, 135, 270, DIAL_RGB565(0, 0, 255), DIAL_RGB565(255, 0, 0));
+
+    bench("ring a8", &ring, NULL);
+    bench("ring solid", &ring, &solid);
+    bench("ring linear", &ring, &linear);
+    bench("ring conic", &ring, &conic);
+    bench("disc solid", &knob, &solid);
+}
@@ -0,0 +1,283 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_async_memcpy.h"
+#include "esp_cache.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#endif
+
+#include "fb_blit.h"
+
+static const char *TAG = "fb_blit";
+
+typedef struct {
+    fb_blit_handle_t blit;
+    atomic_uint pending; // Outstanding DMA transfers, plus one held by the submitter while queueing
+    volatile bool in_use;
+    esp_err_t status;
+    fb_blit_done_cb_t done_cb;
+    void *user_ctx;
+} fb_blit_batch_t;
+
+struct fb_blit_t {
+    fb_blit_config_t config;
+#if !CONFIG_IDF_TARGET_LINUX
+    async_memcpy_handle_t mcp;
+#endif
+    SemaphoreHandle_t batch_slots; // Counts free entries in batches[]
+    SemaphoreHandle_t lock;
+    fb_blit_batch_t batches[FB_BLIT_MAX_BATCHES];
+};
+
+static bool IRAM_ATTR batch_release(fb_blit_batch_t *batch, bool in_isr)
+{
+    if (atomic_fetch_sub(&batch->pending, 1) != 1) {
+        return false;
+    }
+
+    fb_blit_handle_t blit = batch->blit;
+    bool need_yield = false;
+    if (batch->done_cb) {
+        need_yield = batch->done_cb(blit, batch->status, batch->user_ctx);
+    }
+    batch->in_use = false;
+    if (in_isr) {
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(blit->batch_slots, &woken);
+        need_yield |= woken == pdTRUE;
+    } else {
+        xSemaphoreGive(blit->batch_slots);
+    }
+    return need_yield;
+}
+
+static esp_err_t cpu_copy(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    if (n == 0) {
+        return ESP_OK;
+    }
+    memcpy(dst, src, n);
+#if !CONFIG_IDF_TARGET_LINUX
+    // The LCD scans PSRAM directly, so CPU-written bytes must not be left sitting in the cache
+    if (esp_ptr_external_ram(dst)) {
+        ESP_RETURN_ON_ERROR(esp_cache_msync(dst, n, ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED),
+                            TAG, "writeback cpu copy");
+    }
+#endif
+    return ESP_OK;
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+static bool IRAM_ATTR fb_blit_dma_done(async_memcpy_handle_t mcp, async_memcpy_event_t *event, void *cb_args)
+{
+    return batch_release(cb_args, true);
+}
+
+// GDMA reaches DMA-capable internal RAM and PSRAM only. esp_ptr_external_ram() would also take in flash-mapped
+// rodata, which shares the external data window on the S3.
+static inline bool dma_reachable(const void *ptr)
+{
+    return esp_ptr_dma_capable(ptr) || esp_ptr_dma_ext_capable(ptr);
+}
+
+static inline size_t trans_align(const fb_blit_handle_t blit, const void *ptr)
+{
+    return esp_ptr_dma_ext_capable(ptr) ? blit->config.psram_trans_align : blit->config.sram_trans_align;
+}
+
+static esp_err_t dma_copy(fb_blit_handle_t blit, fb_blit_batch_t *batch, uint8_t *dst, const uint8_t *src, size_t n)
+{
+    // Source must be in memory before the DMA reads it. Destination lines are written back first so that nothing
+    // dirty gets evicted over the DMA'd data later, then dropped so the CPU re-reads what the DMA wrote.
+    if (esp_ptr_dma_ext_capable(src)) {
+        ESP_RETURN_ON_ERROR(esp_cache_msync((void *)src, n, ESP_CACHE_MSYNC_FLAG_DIR_C2M), TAG, "writeback src");
+    }
+    if (esp_ptr_dma_ext_capable(dst)) {
+        ESP_RETURN_ON_ERROR(esp_cache_msync(dst, n, ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_INVALIDATE),
+                            TAG, "writeback/invalidate dst");
+    }
+
+    atomic_fetch_add(&batch->pending, 1);
+    esp_err_t ret = esp_async_memcpy(blit->mcp, dst, (void *)src, n, fb_blit_dma_done, batch);
+    if (ret == ESP_OK) {
+        return ESP_OK;
+    }
+    atomic_fetch_sub(&batch->pending, 1);
+    // No free transaction: the backlog is full, or a finished one hasn't been recycled yet (the driver does that
+    // after our callback returns). The engine is saturated either way, so the CPU takes this piece.
+    if (ret == ESP_ERR_INVALID_STATE) {
+        return cpu_copy(dst, src, n);
+    }
+    ESP_RETURN_ON_ERROR(ret, TAG, "dma copy of %zu bytes failed", n);
+    return ESP_OK;
+}
+#endif
+
+static esp_err_t copy_row(fb_blit_handle_t blit, fb_blit_batch_t *batch, uint8_t *dst, const uint8_t *src, size_t n)
+{
+#if !CONFIG_IDF_TARGET_LINUX
+    if (!dma_reachable(dst) || !dma_reachable(src)) {
+        return cpu_copy(dst, src, n);
+    }
+    size_t align = trans_align(blit, dst);
+    size_t src_align = trans_align(blit, src);
+    align = src_align > align ? src_align : align;
+
+    // The DMA body starts where dst is aligned; src has to land on a boundary at the same offset
+    size_t head = (align - ((uintptr_t)dst & (align - 1))) & (align - 1);
+    if (n > head && (((uintptr_t)src + head) & (align - 1)) == 0) {
+        size_t body = (n - head) & ~(align - 1);
+        if (body >= blit->config.min_dma_bytes) {
+            ESP_RETURN_ON_ERROR(cpu_copy(dst, src, head), TAG, "copy head");
+            ESP_RETURN_ON_ERROR(dma_copy(blit, batch, dst + head, src + head, body), TAG, "queue dma body");
+            return cpu_copy(dst + head + body, src + head + body, n - head - body);
+        }
+    }
+#endif
+    return cpu_copy(dst, src, n);
+}
+
+esp_err_t fb_blit_new(const fb_blit_config_t *config, fb_blit_handle_t *ret_blit)
+{
+    ESP_RETURN_ON_FALSE(config && ret_blit, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->backlog > 0, ESP_ERR_INVALID_ARG, TAG, "backlog must be non-zero");
+    ESP_RETURN_ON_FALSE(config->sram_trans_align && !(config->sram_trans_align & (config->sram_trans_align - 1)),
+                        ESP_ERR_INVALID_ARG, TAG, "sram_trans_align must be a power of two");
+    ESP_RETURN_ON_FALSE(config->psram_trans_align && !(config->psram_trans_align & (config->psram_trans_align - 1)),
+                        ESP_ERR_INVALID_ARG, TAG, "psram_trans_align must be a power of two");
+
+    esp_err_t ret = ESP_OK;
+    fb_blit_handle_t blit = calloc(1, sizeof(struct fb_blit_t));
+    ESP_RETURN_ON_FALSE(blit, ESP_ERR_NO_MEM, TAG, "no mem for blit service");
+    blit->config = *config;
+
+#if !CONFIG_IDF_TARGET_LINUX
+    // PSRAM destinations get invalidated line by line, so DMA bodies can never be finer than a cache line
+    size_t cache_align = 0;
+    ESP_GOTO_ON_ERROR(esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &cache_align), err, TAG, "query cache alignment");
+    if (cache_align > blit->config.psram_trans_align) {
+        blit->config.psram_trans_align = cache_align;
+    }
+
+    async_memcpy_config_t mcp_config = ASYNC_MEMCPY_DEFAULT_CONFIG();
+    mcp_config.backlog = blit->config.backlog;
+    mcp_config.sram_trans_align = blit->config.sram_trans_align;
+    mcp_config.psram_trans_align = blit->config.psram_trans_align;
+    ESP_GOTO_ON_ERROR(esp_async_memcpy_install(&mcp_config, &blit->mcp), err, TAG, "install async memcpy");
+#endif
+    blit->batch_slots = xSemaphoreCreateCounting(FB_BLIT_MAX_BATCHES, FB_BLIT_MAX_BATCHES);
+    ESP_GOTO_ON_FALSE(blit->batch_slots, ESP_ERR_NO_MEM, err, TAG, "no mem for batch slots");
+    blit->lock = xSemaphoreCreateMutex();
+    ESP_GOTO_ON_FALSE(blit->lock, ESP_ERR_NO_MEM, err, TAG, "no mem for lock");
+    for (int i = 0; i < FB_BLIT_MAX_BATCHES; i++) {
+        blit->batches[i].blit = blit;
+    }
+
+    ESP_LOGD(TAG, "new blit service @%p, psram align %zu, backlog %zu", blit, blit->config.psram_trans_align,
+             blit->config.backlog);
+    *ret_blit = blit;
+    return ESP_OK;
+
+err:
+    fb_blit_del(blit);
+    return ret;
+}
+
+esp_err_t fb_blit_del(fb_blit_handle_t blit)
+{
+    ESP_RETURN_ON_FALSE(blit, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (blit->batch_slots) {
+        ESP_RETURN_ON_ERROR(fb_blit_wait_idle(blit, portMAX_DELAY), TAG, "wait for outstanding batches");
+        vSemaphoreDelete(blit->batch_slots);
+    }
+    if (blit->lock) {
+        vSemaphoreDelete(blit->lock);
+    }
+#if !CONFIG_IDF_TARGET_LINUX
+    if (blit->mcp) {
+        esp_async_memcpy_uninstall(blit->mcp);
+    }
+#endif
+    free(blit);
+    return ESP_OK;
+}
+
+esp_err_t fb_blit_submit(fb_blit_handle_t blit, const fb_blit_rect_t *rects, size_t num_rects,
+                         fb_blit_done_cb_t done_cb, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(blit && (rects || !num_rects), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    xSemaphoreTake(blit->batch_slots, portMAX_DELAY);
+    fb_blit_batch_t *batch = NULL;
+    xSemaphoreTake(blit->lock, portMAX_DELAY);
+    for (int i = 0; i < FB_BLIT_MAX_BATCHES; i++) {
+        if (!blit->batches[i].in_use) {
+            batch = &blit->batches[i];
+            break;
+        }
+    }
+    assert(batch);
+    batch->in_use = true;
+    batch->status = ESP_OK;
+    batch->done_cb = done_cb;
+    batch->user_ctx = user_ctx;
+    atomic_store(&batch->pending, 1);
+    xSemaphoreGive(blit->lock);
+
+    esp_err_t ret = ESP_OK;
+    for (size_t r = 0; r < num_rects && ret == ESP_OK; r++) {
+        const fb_blit_rect_t *rect = &rects[r];
+        uint8_t *dst = rect->dst;
+        const uint8_t *src = rect->src;
+        // Full-width rects (e.g. a whole framebuffer) go out as a single transfer
+        if (rect->dst_stride == rect->width && rect->src_stride == rect->width) {
+            ret = copy_row(blit, batch, dst, src, rect->width * rect->height);
+            continue;
+        }
+        for (size_t y = 0; y < rect->height && ret == ESP_OK; y++) {
+            ret = copy_row(blit, batch, dst + y * rect->dst_stride, src + y * rect->src_stride, rect->width);
+        }
+    }
+
+    // Drop the submitter's reference; if no DMA is outstanding this completes the batch right here. Transfers queued
+    // before a failure still land, so the batch completes either way, carrying the error.
+    batch->status = ret;
+    batch_release(batch, false);
+    ESP_RETURN_ON_ERROR(ret, TAG, "batch submit failed");
+    return ESP_OK;
+}
+
+esp_err_t fb_blit_wait_idle(fb_blit_handle_t blit, TickType_t ticks_to_wait)
+{
+    ESP_RETURN_ON_FALSE(blit, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    // Idle means every batch slot is free: take them all, then hand them back
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    int taken = 0;
+    while (taken < FB_BLIT_MAX_BATCHES) {
+        if (xSemaphoreTake(blit->batch_slots, ticks_to_wait) != pdTRUE) {
+            break;
+        }
+        taken++;
+        if (xTaskCheckForTimeOut(&timeout, &ticks_to_wait) == pdTRUE) {
+            ticks_to_wait = 0;
+        }
+    }
+    for (int i = 0; i < taken; i++) {
+        xSemaphoreGive(blit->batch_slots);
+    }
+    return taken == FB_BLIT_MAX_BATCHES ? ESP_OK : ESP_ERR_TIMEOUT;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Batches that may be in flight at once; fb_blit_submit() blocks while all are busy
+#define FB_BLIT_MAX_BATCHES 4
+
+typedef struct fb_blit_t *fb_blit_handle_t;
+
+/**
+ * @brief Completion callback for a batch
+ *
+ * Runs from the GDMA interrupt when the last DMA transfer of the batch finishes, or from the submitting task if
+ * the whole batch was copied by the CPU. Keep it short and ISR-safe.
+ *
+ * @param status ESP_OK if every copy landed, otherwise the error fb_blit_submit() returned. Rows before the failure
+ *               were copied; rows after it were not.
+ * @return Whether a higher priority task was woken (e.g. by xSemaphoreGiveFromISR)
+ */
+typedef bool (*fb_blit_done_cb_t)(fb_blit_handle_t blit, esp_err_t status, void *user_ctx);
+
+/**
+ * @brief Rectangular copy between two strided buffers
+ */
+typedef struct {
+    void *dst;
+    const void *src;
+    size_t dst_stride; /*!< Bytes between the starts of consecutive destination rows */
+    size_t src_stride; /*!< Bytes between the starts of consecutive source rows */
+    size_t width;      /*!< Bytes copied per row */
+    size_t height;     /*!< Number of rows */
+} fb_blit_rect_t;
+
+typedef struct {
+    size_t backlog;           /*!< DMA transfers queued at once; pieces that find the queue full go to the CPU */
+    size_t sram_trans_align;  /*!< DMA alignment for internal RAM */
+    size_t psram_trans_align; /*!< DMA alignment for PSRAM, match esp_lcd_rgb_panel_config_t.psram_trans_align */
+    size_t min_dma_bytes;     /*!< Row pieces shorter than this are copied by the CPU */
+} fb_blit_config_t;
+
+#define FB_BLIT_DEFAULT_CONFIG() \
+    {                            \
+        .backlog = 16,           \
+        .sram_trans_align = 4,   \
+        .psram_trans_align = 64, \
+        .min_dma_bytes = 256,    \
+    }
+
+/**
+ * @brief Create a blit service
+ *
+ * On the ESP32-S3 copies go through the async memcpy (GDMA) engine. On the linux target every copy is done by
+ * the CPU, with the same batching and completion semantics.
+ */
+esp_err_t fb_blit_new(const fb_blit_config_t *config, fb_blit_handle_t *ret_blit);
+
+/**
+ * @brief Wait for outstanding batches and free the service
+ */
+esp_err_t fb_blit_del(fb_blit_handle_t blit);
+
+/**
+ * @brief Queue a batch of rectangular copies
+ *
+ * Each row is split into an unaligned head and tail, copied by the CPU before this returns, and an aligned body
+ * handed to the DMA engine. Rows too short or too misaligned for DMA, rows with either end outside DMA-capable
+ * memory (such as const assets in flash), and bodies that find the DMA queue full, are copied by the CPU instead.
+ *
+ * Cache rules for PSRAM: sources are written back and destinations written back and invalidated before the DMA
+ * starts, so the CPU must not touch destination rows until the batch completes. Everything the CPU copies into
+ * PSRAM is written back before this returns, so the LCD DMA never scans out stale bytes.
+ *
+ * @param done_cb Called once the batch is finished, may be NULL. Also called if this returns an error, once the
+ *                transfers queued before the failure have landed.
+ */
+esp_err_t fb_blit_submit(fb_blit_handle_t blit, const fb_blit_rect_t *rects, size_t num_rects,
+                         fb_blit_done_cb_t done_cb, void *user_ctx);
+
+/**
+ * @brief Block until every submitted batch has completed
+ *
+ * @return ESP_ERR_TIMEOUT if batches are still in flight after ticks_to_wait
+ */
+esp_err_t fb_blit_wait_idle(fb_blit_handle_t blit, TickType_t ticks_to_wait);
+
+#ifdef __cplusplus
+}
+#endif
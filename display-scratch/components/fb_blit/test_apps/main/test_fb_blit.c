@@ -0,0 +1,300 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "unity.h"
+#if CONFIG_SPIRAM
+#include "esp_heap_caps.h"
+#endif
+
+#include "fb_blit.h"
+
+#define WAIT_TICKS pdMS_TO_TICKS(1000)
+#define SENTINEL 0xA5
+
+typedef struct {
+    atomic_int calls;
+    esp_err_t status;
+} done_ctx_t;
+
+static bool count_done(fb_blit_handle_t blit, esp_err_t status, void *user_ctx)
+{
+    done_ctx_t *ctx = user_ctx;
+    ctx->status = status;
+    atomic_fetch_add(&ctx->calls, 1);
+    return false;
+}
+
+// Framebuffers live in PSRAM on the board, so exercise the same path there
+static uint8_t *alloc_buf(size_t n)
+{
+#if CONFIG_SPIRAM
+    uint8_t *buf = heap_caps_aligned_calloc(64, 1, n, MALLOC_CAP_SPIRAM);
+#else
+    uint8_t *buf = aligned_alloc(64, (n + 63) & ~(size_t)63);
+#endif
+    TEST_ASSERT_NOT_NULL(buf);
+    return buf;
+}
+
+static void fill_pattern(uint8_t *buf, size_t n, uint32_t seed)
+{
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = seed >> 16;
+    }
+}
+
+static fb_blit_handle_t new_blit(void)
+{
+    fb_blit_config_t config = FB_BLIT_DEFAULT_CONFIG();
+    fb_blit_handle_t blit = NULL;
+    TEST_ESP_OK(fb_blit_new(&config, &blit));
+    return blit;
+}
+
+// Copy rect (x, y, w, h) of src into dst at (dx, dy) and check it byte for byte, with everything else untouched
+static void check_rect_copy(fb_blit_handle_t blit, size_t src_stride, size_t dst_stride, size_t rows,
+                            size_t x, size_t y, size_t dx, size_t dy, size_t w, size_t h)
+{
+    uint8_t *src = alloc_buf(src_stride * rows);
+    uint8_t *dst = alloc_buf(dst_stride * rows);
+    fill_pattern(src, src_stride * rows, (uint32_t)(x * 31 + w));
+    memset(dst, SENTINEL, dst_stride * rows);
+
+    fb_blit_rect_t rect = {
+        .dst = dst + dy * dst_stride + dx,
+        .src = src + y * src_stride + x,
+        .dst_stride = dst_stride,
+        .src_stride = src_stride,
+        .width = w,
+        .height = h,
+    };
+    done_ctx_t done = {0};
+    TEST_ESP_OK(fb_blit_submit(blit, &rect, 1, count_done, &done));
+    TEST_ESP_OK(fb_blit_wait_idle(blit, WAIT_TICKS));
+    TEST_ASSERT_EQUAL(1, atomic_load(&done.calls));
+    TEST_ASSERT_EQUAL(ESP_OK, done.status);
+
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; c < dst_stride; c++) {
+            uint8_t got = dst[r * dst_stride + c];
+            bool inside = r >= dy && r < dy + h && c >= dx && c < dx + w;
+            uint8_t want = inside ? src[(r - dy + y) * src_stride + (c - dx + x)] : SENTINEL;
+            if (got != want) {
+                TEST_FAIL_MESSAGE("copied bytes differ");
+            }
+        }
+    }
+    free(src);
+    free(dst);
+}
+
+TEST_CASE("strided rect copy", "[fb_blit]")
+{
+    fb_blit_handle_t blit = new_blit();
+    check_rect_copy(blit, 960, 960, 120, 128, 10, 256, 40, 512, 64);
+    check_rect_copy(blit, 1024, 768, 100, 64, 0, 0, 20, 640, 80);
+    TEST_ESP_OK(fb_blit_del(blit));
+}
+
+TEST_CASE("full-width rect copy", "[fb_blit]")
+{
+    fb_blit_handle_t blit = new_blit();
+    check_rect_copy(blit, 960, 960, 160, 0, 0, 0, 0, 960, 160);
+    TEST_ESP_OK(fb_blit_del(blit));
+}
+
+TEST_CASE("unaligned head and tail", "[fb_blit]")
+{
+    fb_blit_handle_t blit = new_blit();
+    const size_t offsets[] = {0, 1, 3, 31, 63, 64, 65};
+    for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+        size_t off = offsets[i];
+        // Same misalignment on both sides (DMA body possible), then mismatched (CPU only)
+        check_rect_copy(blit, 1024, 1024, 8, off, 1, off, 2, 700 - off, 4);
+        check_rect_copy(blit, 1024, 1024, 8, off, 1, off + 5, 2, 700, 4);
+        check_rect_copy(blit, 1024, 1024, 8, off, 0, off, 0, 300 + off, 5);
+    }
+    TEST_ESP_OK(fb_blit_del(blit));
+}
+
+TEST_CASE("tiny spans", "[fb_blit]")
+{
+    fb_blit_handle_t blit = new_blit();
+    for (size_t w = 1; w <= 17; w++) {
+        check_rect_copy(blit, 128, 96, 12, w, 2, 96 - w - 1, 3, w, 7);
+    }
+    // Zero-sized rects copy nothing but still complete
+    check_rect_copy(blit, 64, 64, 4, 0, 0, 0, 0, 0, 4);
+    check_rect_copy(blit, 64, 64, 4, 0, 0, 0, 0, 16, 0);
+    TEST_ESP_OK(fb_blit_del(blit));
+}
+
+// Lands in flash .rodata on the board, which the DMA engine can't read: every row has to go through the CPU
+#define B4(i) (i) & 0xFF, ((i) * 7 + 1) & 0xFF, ((i) * 13 + 2) & 0xFF, ((i) * 29 + 3) & 0xFF
+#define B16(i) B4(i), B4((i) + 4), B4((i) + 8), B4((i) + 12)
+#define B64(i) B16(i), B16((i) + 16), B16((i) + 32), B16((i) + 48)
+#define B256(i) B64(i), B64((i) + 64), B64((i) + 128), B64((i) + 192)
+static const uint8_t s_rodata_src[1024] __attribute__((aligned(64))) = {B256(0), B256(256), B256(512), B256(768)};
+
+TEST_CASE("copy from const source", "[fb_blit]")
+{
+    fb_blit_handle_t blit = new_blit();
+    const size_t rows = 8;
+    const size_t dst_stride = 256;
+    uint8_t *dst = alloc_buf(dst_stride * rows);
+    memset(dst, SENTINEL, dst_stride * rows);
+
+    // Full-width rows, then a narrower window into a strided destination
+    fb_blit_rect_t rects[] = {
+        {
+            .dst = dst,
+            .src = s_rodata_src,
+            .dst_stride = 128,
+            .src_stride = 128,
+            .width = 128,
+            .height = 4,
+        },
+        {
+            .dst = dst + 4 * dst_stride + 64,
+            .src = s_rodata_src + 512,
+            .dst_stride = dst_stride,
+            .src_stride = 128,
+            .width = 128,
+            .height = 4,
+        },
+    };
+    done_ctx_t done = {0};
+    TEST_ESP_OK(fb_blit_submit(blit, rects, 2, count_done, &done));
+    TEST_ESP_OK(fb_blit_wait_idle(blit, WAIT_TICKS));
+    TEST_ASSERT_EQUAL(1, atomic_load(&done.calls));
+    TEST_ASSERT_EQUAL(ESP_OK, done.status);
+
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s_rodata_src, dst, 512);
+    TEST_ASSERT_EACH_EQUAL_HEX8(SENTINEL, dst + 512, 512);
+    for (size_t r = 4; r < rows; r++) {
+        uint8_t *row = dst + r * dst_stride;
+        TEST_ASSERT_EACH_EQUAL_HEX8(SENTINEL, row, 64);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(s_rodata_src + 512 + (r - 4) * 128, row + 64, 128);
+        TEST_ASSERT_EACH_EQUAL_HEX8(SENTINEL, row + 192, 64);
+    }
+    free(dst);
+    TEST_ESP_OK(fb_blit_del(blit));
+}
+
+TEST_CASE("completion callback and wait_idle", "[fb_blit]")
+{
+    fb_blit_handle_t blit = new_blit();
+    const size_t stride = 960;
+    const size_t rows = 64;
+    uint8_t *src = alloc_buf(stride * rows);
+    uint8_t *dst = alloc_buf(stride * rows);
+    fill_pattern(src, stride * rows, 7);
+
+    // Batches of several rects, more of them than there are batch slots, so submit has to wait for completions
+    fb_blit_rect_t rects[4];
+    for (int i = 0; i < 4; i++) {
+        rects[i] = (fb_blit_rect_t) {
+            .dst = dst + i * 16 * stride,
+            .src = src + i * 16 * stride,
+            .dst_stride = stride,
+            .src_stride = stride,
+            .width = 640,
+            .height = 16,
+        };
+    }
+    done_ctx_t done = {0};
+    const int batches = FB_BLIT_MAX_BATCHES * 3;
+    for (int i = 0; i < batches; i++) {
+        TEST_ESP_OK(fb_blit_submit(blit, rects, 4, count_done, &done));
+    }
+    // A NULL callback and an empty batch are both fine
+    TEST_ESP_OK(fb_blit_submit(blit, rects, 1, NULL, NULL));
+    TEST_ESP_OK(fb_blit_submit(blit, NULL, 0, count_done, &done));
+
+    TEST_ESP_OK(fb_blit_wait_idle(blit, WAIT_TICKS));
+    TEST_ASSERT_EQUAL(batches + 1, atomic_load(&done.calls));
+    TEST_ASSERT_EQUAL(ESP_OK, done.status);
+    for (size_t r = 0; r < rows; r++) {
+        TEST_ASSERT_EQUAL_MEMORY(src + r * stride, dst + r * stride, 640);
+    }
+    // Idle with nothing outstanding returns straight away
+    TEST_ESP_OK(fb_blit_wait_idle(blit, 0));
+
+    free(src);
+    free(dst);
+    TEST_ESP_OK(fb_blit_del(blit));
+}
+
+TEST_CASE("invalid config", "[fb_blit]")
+{
+    fb_blit_handle_t blit = NULL;
+    fb_blit_config_t config = FB_BLIT_DEFAULT_CONFIG();
+    config.psram_trans_align = 48;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, fb_blit_new(&config, &blit));
+    config = (fb_blit_config_t)FB_BLIT_DEFAULT_CONFIG();
+    config.backlog = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, fb_blit_new(&config, &blit));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, fb_blit_new(NULL, &blit));
+}
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void bench(fb_blit_handle_t blit, const char *name, const fb_blit_rect_t *rect, int iterations)
+{
+    size_t bytes = rect->width * rect->height;
+
+    int64_t start = now_us();
+    for (int i = 0; i < iterations; i++) {
+        TEST_ESP_OK(fb_blit_submit(blit, rect, 1, NULL, NULL));
+    }
+    TEST_ESP_OK(fb_blit_wait_idle(blit, portMAX_DELAY));
+    int64_t blit_us = now_us() - start;
+
+    start = now_us();
+    for (int i = 0; i < iterations; i++) {
+        for (size_t r = 0; r < rect->height; r++) {
+            memcpy((uint8_t *)rect->dst + r * rect->dst_stride, (const uint8_t *)rect->src + r * rect->src_stride,
+                   rect->width);
+        }
+    }
+    int64_t memcpy_us = now_us() - start;
+
+    printf("%-16s %7zu B  fb_blit %8.1f MB/s  memcpy %8.1f MB/s\n", name, bytes,
+           (double)bytes * iterations / (blit_us ? blit_us : 1), (double)bytes * iterations / (memcpy_us ? memcpy_us : 1));
+}
+
+TEST_CASE("throughput", "[fb_blit][bench]")
+{
+    // One 480x480 RGB565 framebuffer, as used by the panel
+    const size_t stride = 480 * 2;
+    const size_t rows = 480;
+    uint8_t *front = alloc_buf(stride * rows);
+    uint8_t *back = alloc_buf(stride * rows);
+    fill_pattern(front, stride * rows, 3);
+    fb_blit_handle_t blit = new_blit();
+
+    fb_blit_rect_t full = {back, front, stride, stride, stride, rows};
+    bench(blit, "fb sync", &full, 20);
+    fb_blit_rect_t dial = {back + 120 * stride + 240, front + 120 * stride + 240, stride, stride, 240 * 2, 240};
+    bench(blit, "240x240 rect", &dial, 50);
+    fb_blit_rect_t odd = {back + 7 * stride + 3, front + 9 * stride + 17, stride, stride, 333, 200};
+    bench(blit, "unaligned rect", &odd, 50);
+    fb_blit_rect_t icon = {back + 20 * stride + 40, front + 20 * stride + 40, stride, stride, 48 * 2, 48};
+    bench(blit, "48x48 icon", &icon, 500);
+
+    TEST_ESP_OK(fb_blit_del(blit));
+    free(front);
+    free(back);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Work that needs the CPU at full clock
+ */
+typedef enum {
+    POWER_GOV_ACTIVITY_RENDER,
+    POWER_GOV_ACTIVITY_TOUCH,
+    POWER_GOV_ACTIVITY_I2C,
+    POWER_GOV_ACTIVITY_MAX,
+} power_gov_activity_t;
+
+typedef enum {
+    POWER_GOV_WAKE_EXPANDER,
+    POWER_GOV_WAKE_TOUCH,
+    POWER_GOV_WAKE_TIMER,
+    POWER_GOV_WAKE_MAX,
+} power_gov_wake_t;
+
+typedef enum {
+    POWER_GOV_STATE_ACTIVE,   /*!< At least one activity running, locks held */
+    POWER_GOV_STATE_LINGER,   /*!< Nothing running, locks still held until the linger deadline */
+    POWER_GOV_STATE_RELEASED, /*!< Locks released. What the hardware does then (lower clock, light sleep) is up to
+                                   the platform and whatever other locks it holds */
+    POWER_GOV_STATE_MAX,
+} power_gov_state_t;
+
+/**
+ * @brief Platform hooks
+ *
+ * Everything time- or hardware-dependent goes through these, so the state machine runs unchanged against a
+ * simulated clock on the host.
+ */
+typedef struct {
+    int64_t (*now_us)(void *ctx);
+    void (*hold)(bool held, void *ctx);             /*!< Take (true) or drop (false) the platform's locks */
+    void (*arm)(int64_t deadline_us, void *ctx);    /*!< Call power_gov_timeout() at or after deadline_us, replacing
+                                                         any earlier deadline. Stale timeouts are harmless. */
+    void *ctx;
+    int64_t linger_us; /*!< How long to keep the locks after the last activity ends, 0 to drop them immediately */
+} power_gov_config_t;
+
+typedef struct {
+    uint32_t count;
+    int64_t min_us;
+    int64_t max_us;
+    int64_t total_us;
+} power_gov_latency_t;
+
+/**
+ * @brief Time and entries per governor state, i.e. how long the locks were held or released. Nothing here measures
+ *        the actual clock or time asleep.
+ */
+typedef struct {
+    power_gov_state_t state;
+    int64_t time_us[POWER_GOV_STATE_MAX]; /*!< Including the time spent so far in the current state */
+    uint32_t entries[POWER_GOV_STATE_MAX];
+    power_gov_latency_t wake[POWER_GOV_WAKE_MAX];
+} power_gov_stats_t;
+
+/**
+ * @brief Governor state; treat as opaque and go through the functions below
+ */
+typedef struct {
+    power_gov_config_t config;
+    power_gov_state_t state;
+    int64_t state_since_us;
+    int64_t deadline_us;
+    uint32_t active[POWER_GOV_ACTIVITY_MAX];
+    uint32_t active_total;
+    bool wake_pending;
+    power_gov_wake_t wake_source;
+    int64_t wake_at_us;
+    power_gov_stats_t stats;
+} power_gov_t;
+
+/**
+ * @brief Start a governor in POWER_GOV_STATE_RELEASED with the locks not held
+ *
+ * now_us and hold are required, and so is arm unless linger_us is 0. The governor does no locking of its own;
+ * callers serialize access. Nothing is allocated, so there is nothing to tear down.
+ */
+void power_gov_init(power_gov_t *gov, const power_gov_config_t *config);
+
+/**
+ * @brief Mark the start of an activity. Calls nest, per activity.
+ *
+ * The first acquire after a power_gov_note_wake() closes that wake's latency measurement.
+ */
+void power_gov_acquire(power_gov_t *gov, power_gov_activity_t activity);
+
+/**
+ * @brief Mark the end of an activity started with power_gov_acquire()
+ */
+void power_gov_release(power_gov_t *gov, power_gov_activity_t activity);
+
+/**
+ * @brief Record a wake-up event (interrupt or timer) while released
+ *
+ * Latency is measured from here to the next power_gov_acquire(). Events while not released, or while an earlier
+ * wake is still unanswered, are ignored.
+ */
+void power_gov_note_wake(power_gov_t *gov, power_gov_wake_t source);
+
+/**
+ * @brief Deliver the deadline requested through power_gov_config_t.arm
+ */
+void power_gov_timeout(power_gov_t *gov);
+
+power_gov_state_t power_gov_get_state(const power_gov_t *gov);
+
+void power_gov_get_stats(const power_gov_t *gov, power_gov_stats_t *stats);
+
+const char *power_gov_state_name(power_gov_state_t state);
+
+const char *power_gov_wake_name(power_gov_wake_t source);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,149 @@
+#include <assert.h>
+#include <string.h>
+
+#include "power_gov.h"
+
+static inline int64_t now_us(const power_gov_t *gov)
+{
+    return gov->config.now_us(gov->config.ctx);
+}
+
+static void enter_state(power_gov_t *gov, power_gov_state_t state, int64_t now)
+{
+    gov->stats.time_us[gov->state] += now - gov->state_since_us;
+    gov->stats.entries[state]++;
+    gov->state = state;
+    gov->state_since_us = now;
+}
+
+void power_gov_init(power_gov_t *gov, const power_gov_config_t *config)
+{
+    assert(gov && config);
+    assert(config->now_us && config->hold);
+    assert(config->linger_us == 0 || config->arm);
+
+    memset(gov, 0, sizeof(*gov));
+    gov->config = *config;
+    gov->state = POWER_GOV_STATE_RELEASED;
+    gov->state_since_us = now_us(gov);
+    gov->stats.entries[POWER_GOV_STATE_RELEASED] = 1;
+    for (int i = 0; i < POWER_GOV_WAKE_MAX; i++) {
+        gov->stats.wake[i].min_us = INT64_MAX;
+    }
+}
+
+void power_gov_acquire(power_gov_t *gov, power_gov_activity_t activity)
+{
+    assert(activity < POWER_GOV_ACTIVITY_MAX);
+    int64_t now = now_us(gov);
+
+    if (gov->wake_pending) {
+        power_gov_latency_t *lat = &gov->stats.wake[gov->wake_source];
+        int64_t latency = now - gov->wake_at_us;
+        lat->count++;
+        lat->total_us += latency;
+        lat->min_us = latency < lat->min_us ? latency : lat->min_us;
+        lat->max_us = latency > lat->max_us ? latency : lat->max_us;
+        gov->wake_pending = false;
+    }
+
+    gov->active[activity]++;
+    gov->active_total++;
+    if (gov->state == POWER_GOV_STATE_RELEASED) {
+        gov->config.hold(true, gov->config.ctx);
+    }
+    if (gov->state != POWER_GOV_STATE_ACTIVE) {
+        enter_state(gov, POWER_GOV_STATE_ACTIVE, now);
+    }
+}
+
+void power_gov_release(power_gov_t *gov, power_gov_activity_t activity)
+{
+    assert(activity < POWER_GOV_ACTIVITY_MAX);
+    assert(gov->active[activity] > 0);
+    gov->active[activity]--;
+    if (--gov->active_total > 0) {
+        return;
+    }
+
+    int64_t now = now_us(gov);
+    if (gov->config.linger_us > 0) {
+        gov->deadline_us = now + gov->config.linger_us;
+        enter_state(gov, POWER_GOV_STATE_LINGER, now);
+        gov->config.arm(gov->deadline_us, gov->config.ctx);
+    } else {
+        enter_state(gov, POWER_GOV_STATE_RELEASED, now);
+        gov->config.hold(false, gov->config.ctx);
+    }
+}
+
+void power_gov_note_wake(power_gov_t *gov, power_gov_wake_t source)
+{
+    assert(source < POWER_GOV_WAKE_MAX);
+    if (gov->state != POWER_GOV_STATE_RELEASED || gov->wake_pending) {
+        return;
+    }
+    gov->wake_pending = true;
+    gov->wake_source = source;
+    gov->wake_at_us = now_us(gov);
+}
+
+void power_gov_timeout(power_gov_t *gov)
+{
+    if (gov->state != POWER_GOV_STATE_LINGER) {
+        return;
+    }
+    int64_t now = now_us(gov);
+    if (now < gov->deadline_us) {
+        // Fired early (or for a deadline that has since moved), wait for the current one
+        gov->config.arm(gov->deadline_us, gov->config.ctx);
+        return;
+    }
+    enter_state(gov, POWER_GOV_STATE_RELEASED, now);
+    gov->config.hold(false, gov->config.ctx);
+}
+
+power_gov_state_t power_gov_get_state(const power_gov_t *gov)
+{
+    return gov->state;
+}
+
+void power_gov_get_stats(const power_gov_t *gov, power_gov_stats_t *stats)
+{
+    *stats = gov->stats;
+    stats->state = gov->state;
+    stats->time_us[gov->state] += now_us(gov) - gov->state_since_us;
+    for (int i = 0; i < POWER_GOV_WAKE_MAX; i++) {
+        if (stats->wake[i].count == 0) {
+            stats->wake[i].min_us = 0;
+        }
+    }
+}
+
+const char *power_gov_state_name(power_gov_state_t state)
+{
+    switch (state) {
+    case POWER_GOV_STATE_ACTIVE:
+        return "active";
+    case POWER_GOV_STATE_LINGER:
+        return "linger";
+    case POWER_GOV_STATE_RELEASED:
+        return "released";
+    default:
+        return "?";
+    }
+}
+
+const char *power_gov_wake_name(power_gov_wake_t source)
+{
+    switch (source) {
+    case POWER_GOV_WAKE_EXPANDER:
+        return "expander";
+    case POWER_GOV_WAKE_TOUCH:
+        return "touch";
+    case POWER_GOV_WAKE_TIMER:
+        return "timer";
+    default:
+        return "?";
+    }
+}
@@ -0,0 +1,270 @@
+/*
+ * Unit tests for the activity governor.
+ *
+ * The platform hooks are fakes: a clock the test advances by hand, a lock that counts take/drop calls, and a
+ * timer that just remembers the last deadline it was armed with.
+ */
+#include <stdbool.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "power_gov.h"
+
+#define LINGER_US 1000
+
+typedef struct {
+    int64_t now;
+    bool held;
+    int holds;    // hold(true) calls
+    int releases; // hold(false) calls
+    int arms;
+    int64_t armed_deadline;
+} fake_t;
+
+static fake_t s_fake;
+static power_gov_t s_gov;
+
+static void check_state(power_gov_state_t want)
+{
+    TEST_ASSERT_EQUAL_STRING(power_gov_state_name(want), power_gov_state_name(power_gov_get_state(&s_gov)));
+}
+
+static int64_t fake_now(void *ctx)
+{
+    return ((fake_t *)ctx)->now;
+}
+
+static void fake_hold(bool held, void *ctx)
+{
+    fake_t *fake = ctx;
+    TEST_ASSERT_MESSAGE(held != fake->held, held ? "locks taken twice" : "locks dropped twice");
+    fake->held = held;
+    held ? fake->holds++ : fake->releases++;
+}
+
+static void fake_arm(int64_t deadline_us, void *ctx)
+{
+    fake_t *fake = ctx;
+    fake->arms++;
+    fake->armed_deadline = deadline_us;
+}
+
+static void setup_gov(int64_t linger_us)
+{
+    memset(&s_fake, 0, sizeof(s_fake));
+    s_fake.now = 5000;
+    power_gov_config_t config = {
+        .now_us = fake_now,
+        .hold = fake_hold,
+        .arm = linger_us ? fake_arm : NULL,
+        .ctx = &s_fake,
+        .linger_us = linger_us,
+    };
+    power_gov_init(&s_gov, &config);
+}
+
+TEST_CASE("starts released", "[power_gov]")
+{
+    setup_gov(LINGER_US);
+    check_state(POWER_GOV_STATE_RELEASED);
+    TEST_ASSERT_FALSE(s_fake.held);
+    TEST_ASSERT_EQUAL(0, s_fake.holds);
+    // Timeouts outside LINGER are stale and ignored
+    power_gov_timeout(&s_gov);
+    check_state(POWER_GOV_STATE_RELEASED);
+    TEST_ASSERT_EQUAL(0, s_fake.arms);
+    TEST_ASSERT_EQUAL(0, s_fake.releases);
+}
+
+TEST_CASE("nested acquires", "[power_gov]")
+{
+    setup_gov(LINGER_US);
+    power_gov_acquire(&s_gov, POWER_GOV_ACTIVITY_RENDER);
+    power_gov_acquire(&s_gov, POWER_GOV_ACTIVITY_RENDER);
+    power_gov_acquire(&s_gov, POWER_GOV_ACTIVITY_I2C);
+    check_state(POWER_GOV_STATE_ACTIVE);
+    TEST_ASSERT_EQUAL(1, s_fake.holds);
+
+    power_gov_release(&s_gov, POWER_GOV_ACTIVITY_RENDER);
+    power_gov_release(&s_gov, POWER_GOV_ACTIVITY_I2C);
+    check_state(POWER_GOV_STATE_ACTIVE);
+    TEST_ASSERT_EQUAL_MESSAGE(0, s_fake.arms, "armed with an activity still held");
+
+    s_fake.now += 200;
+    power_gov_release(&s_gov, POWER_GOV_ACTIVITY_RENDER);
+    check_state(POWER_GOV_STATE_LINGER);
+    TEST_ASSERT_TRUE_MESSAGE(s_fake.held, "locks dropped on entering linger");
+    TEST_ASSERT_EQUAL(1, s_fake.arms);
+    TEST_ASSERT_EQUAL(5200 + LINGER_US, s_fake.armed_deadline);
+
+    s_fake.now = s_fake.armed_deadline;
+    power_gov_timeout(&s_gov);
+    check_state(POWER_GOV_STATE_RELEASED);
+    TEST_ASSERT_FALSE(s_fake.held);
+    TEST_ASSERT_EQUAL(1, s_fake.releases);
+}
+
+TEST_CASE("re-acquire during linger", "[power_gov]")
+{
+    setup_gov(LINGER_US);
+    power_gov_acquire(&s_gov, POWER_GOV_ACTIVITY_TOUCH);
+    power_gov_release(&s_gov, POWER_GOV_ACTIVITY_TOUCH);
+    int64_t first_deadline = s_fake.armed_deadline;
+
+    s_fake.now += 600;
+    power_gov_acquire(&s_gov, POWER_GOV_ACTIVITY_RENDER);
+    check_state(POWER_GOV_STATE_ACTIVE);
+    TEST_ASSERT_EQUAL_MESSAGE(1, s_fake.holds, "locks taken again while lingering");
+    s_fake.now += 100;
+    power_gov_release(&s_gov, POWER_GOV_ACTIVITY_RENDER);
+    check_state(POWER_GOV_STATE_LINGER);
+    int64_t second_deadline = s_fake.armed_deadline;
+    TEST_ASSERT_EQUAL_MESSAGE(s_fake.now + LINGER_US, second_deadline, "linger not restarted");
+
+    // The timer set for the first linger can still fire; it must not cut the second one short
+    s_fake.now = first_deadline;
+    power_gov_timeout(&s_gov);
+    check_state(POWER_GOV_STATE_LINGER);
+    TEST_ASSERT_EQUAL(second_deadline, s_fake.armed_deadline);
+
+    s_fake.now = second_deadline;
+    power_gov_timeout(&s_gov);
+    check_state(POWER_GOV_STATE_RELEASED);
+    TEST_ASSERT_EQUAL(1, s_fake.holds);
+    TEST_ASSERT_EQUAL(1, s_fake.releases);
+}
+
+TEST_CASE("early timeout re-arms", "[power_gov]")
+{
+    setup_gov(LINGER_US);
+    power_gov_acquire(&s_gov, POWER_GOV_ACTIVITY_I2C);
+    power_gov_release(&s_gov, POWER_GOV_ACTIVITY_I2C);
+    int64_t deadline = s_fake.armed_deadline;
+
+    // esp_timer can run the callback a tick early; the governor must wait for the real deadline
+    for (int64_t early = 300; early > 0; early -= 100) {
+        int arms = s_fake.arms;
+        s_fake.now = deadline - early;
+        power_gov_timeout(&s_gov);
+        check_state(POWER_GOV_STATE_LINGER);
+        TEST_ASSERT_EQUAL(arms + 1, s_fake.arms);
+        TEST_ASSERT_EQUAL(deadline, s_fake.armed_deadline);
+    }
+    s_fake.now = deadline + 50;
+    power_gov_timeout(&s_gov);
+    check_state(POWER_GOV_STATE_RELEASED);
+    TEST_ASSERT_FALSE(s_fake.held);
+}
+
+TEST_CASE("linger 0", "[power_gov]")
+{
+    setup_gov(0);
+    power_gov_acquire(&s_gov, POWER_GOV_ACTIVITY_RENDER);
+    TEST_ASSERT_TRUE(s_fake.held);
+    power_gov_release(&s_gov, POWER_GOV_ACTIVITY_RENDER);
+    check_state(POWER_GOV_STATE_RELEASED);
+    TEST_ASSERT_FALSE(s_fake.held);
+    TEST_ASSERT_EQUAL(0, s_fake.arms);
+
+    power_gov_stats_t stats;
+    power_gov_get_stats(&s_gov, &stats);
+    TEST_ASSERT_EQUAL(0, stats.entries[POWER_GOV_STATE_LINGER]);
+}
+
+TEST_CASE("state time accounting", "[power_gov]")
+{
+    setup_gov(LINGER_US);
+    s_fake.now += 1250; // released
+    power_gov_acquire(&s_gov, POWER_GOV_ACTIVITY_RENDER);
+    s_fake.now += 400; // active
+    power_gov_release(&s_gov, POWER_GOV_ACTIVITY_RENDER);
+    s_fake.now += 300; // lingering, then re-acquired
+    power_gov_acquire(&s_gov, POWER_GOV_ACTIVITY_RENDER);
+    s_fake.now += 500; // active
+    power_gov_release(&s_gov, POWER_GOV_ACTIVITY_RENDER);
+    s_fake.now += LINGER_US; // lingering to the deadline
+    power_gov_timeout(&s_gov);
+    s_fake.now += 1900; // released, still in progress
+
+    power_gov_stats_t stats;
+    power_gov_get_stats(&s_gov, &stats);
+    TEST_ASSERT_EQUAL(POWER_GOV_STATE_RELEASED, stats.state);
+    const int64_t want_us[POWER_GOV_STATE_MAX] = {
+        [POWER_GOV_STATE_ACTIVE] = 400 + 500,
+        [POWER_GOV_STATE_LINGER] = 300 + LINGER_US,
+        [POWER_GOV_STATE_RELEASED] = 1250 + 1900,
+    };
+    const uint32_t want_entries[POWER_GOV_STATE_MAX] = {
+        [POWER_GOV_STATE_ACTIVE] = 2,
+        [POWER_GOV_STATE_LINGER] = 2,
+        [POWER_GOV_STATE_RELEASED] = 2,
+    };
+    for (int i = 0; i < POWER_GOV_STATE_MAX; i++) {
+        TEST_ASSERT_EQUAL_MESSAGE(want_us[i], stats.time_us[i], power_gov_state_name(i));
+        TEST_ASSERT_EQUAL_MESSAGE(want_entries[i], stats.entries[i], power_gov_state_name(i));
+    }
+
+    // Reading the stats must not move the in-progress state's start
+    s_fake.now += 100;
+    power_gov_get_stats(&s_gov, &stats);
+    TEST_ASSERT_EQUAL(1250 + 1900 + 100, stats.time_us[POWER_GOV_STATE_RELEASED]);
+}
+
+TEST_CASE("wake latency", "[power_gov]")
+{
+    setup_gov(0);
+    power_gov_stats_t stats;
+    power_gov_get_stats(&s_gov, &stats);
+    for (int i = 0; i < POWER_GOV_WAKE_MAX; i++) {
+        TEST_ASSERT_EQUAL_MESSAGE(0, stats.wake[i].count, power_gov_wake_name(i));
+        TEST_ASSERT_EQUAL_MESSAGE(0, stats.wake[i].min_us, power_gov_wake_name(i));
+    }
+
+    const struct {
+        power_gov_wake_t source;
+        int64_t latency_us;
+    } wakes[] = {
+        {POWER_GOV_WAKE_EXPANDER, 350},
+        {POWER_GOV_WAKE_TOUCH, 120},
+        {POWER_GOV_WAKE_EXPANDER, 90},
+        {POWER_GOV_WAKE_EXPANDER, 1200},
+    };
+    for (size_t i = 0; i < sizeof(wakes) / sizeof(wakes[0]); i++) {
+        s_fake.now += 10000;
+        power_gov_note_wake(&s_gov, wakes[i].source);
+        s_fake.now += wakes[i].latency_us / 2;
+        // A second event before the first is answered belongs to the same wake-up
+        power_gov_note_wake(&s_gov, POWER_GOV_WAKE_TIMER);
+        s_fake.now += wakes[i].latency_us - wakes[i].latency_us / 2;
+        power_gov_acquire(&s_gov, POWER_GOV_ACTIVITY_I2C);
+        // Events while the locks are held are not wake-ups
+        power_gov_note_wake(&s_gov, POWER_GOV_WAKE_TIMER);
+        s_fake.now += 50;
+        power_gov_release(&s_gov, POWER_GOV_ACTIVITY_I2C);
+    }
+
+    power_gov_get_stats(&s_gov, &stats);
+    const power_gov_latency_t *exp = &stats.wake[POWER_GOV_WAKE_EXPANDER];
+    TEST_ASSERT_EQUAL(3, exp->count);
+    TEST_ASSERT_EQUAL(90, exp->min_us);
+    TEST_ASSERT_EQUAL(1200, exp->max_us);
+    TEST_ASSERT_EQUAL(350 + 90 + 1200, exp->total_us);
+    const power_gov_latency_t *touch = &stats.wake[POWER_GOV_WAKE_TOUCH];
+    TEST_ASSERT_EQUAL(1, touch->count);
+    TEST_ASSERT_EQUAL(120, touch->min_us);
+    TEST_ASSERT_EQUAL(120, touch->max_us);
+    TEST_ASSERT_EQUAL(120, touch->total_us);
+    TEST_ASSERT_EQUAL(0, stats.wake[POWER_GOV_WAKE_TIMER].count);
+
+    // Only the first acquire after a wake closes it
+    s_fake.now += 10000;
+    power_gov_note_wake(&s_gov, POWER_GOV_WAKE_TIMER);
+    s_fake.now += 40;
+    power_gov_acquire(&s_gov, POWER_GOV_ACTIVITY_RENDER);
+    s_fake.now += 500;
+    power_gov_acquire(&s_gov, POWER_GOV_ACTIVITY_I2C);
+    power_gov_get_stats(&s_gov, &stats);
+    TEST_ASSERT_EQUAL(1, stats.wake[POWER_GOV_WAKE_TIMER].count);
+    TEST_ASSERT_EQUAL(40, stats.wake[POWER_GOV_WAKE_TIMER].max_us);
+}
@@ -6,6 +6,7 @@
    software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
    CONDITIONS OF ANY KIND, either express or implied.
 */
+#include <inttypes.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -23,6 +24,7 @@
 #include "lwip/sys.h"
 #include "driver/ledc.h"
 
+#include "power_pm.h"
 #include "type_9_init_cmds.h"
 
 static const char *TAG = "display-scratch";
@@ -62,8 +64,25 @@ static const char *TAG = "display-scratch";
 
 #define BACKLIGHT_TIMER_RESOLUTION LEDC_TIMER_8_BIT
 
+// Expander INT wake handler. Reading the input port is what releases the INT line.
+static void expander_wake(power_gov_wake_t source, void *ctx)
+{
+    esp_io_expander_handle_t io_expander = ctx;
+    uint32_t inputs = 0;
+    esp_err_t ret = io_expander->read_input_reg(io_expander, &inputs);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Reading expander inputs failed: %s", esp_err_to_name(ret));
+        return;
+    }
+    ESP_LOGD(TAG, "Expander inputs 0x%04" PRIx32, inputs);
+}
+
 void app_main(void)
 {
+    ESP_LOGI(TAG, "Configuring power management");
+    ESP_ERROR_CHECK(power_pm_init());
+    power_pm_acquire(POWER_GOV_ACTIVITY_RENDER);
+
     ESP_LOGI(TAG, "Configuring backlight");
     gpio_set_direction(LCD_BL_IO, TCP_OUTPUT_DEBUG);
     gpio_set_level(LCD_BL_IO, 0);
@@ -99,6 +118,7 @@ void app_main(void)
     ESP_ERROR_CHECK(i2c_driver_install(i2c_port, i2c_conf.mode, I2C_RX_BUF_DISABLE, I2C_TX_BUF_DISABLE, 0));
 
     ESP_LOGI(TAG, " %u", I2C_NUM_1);
+    power_pm_acquire(POWER_GOV_ACTIVITY_I2C);
     esp_io_expander_handle_t io_expander = NULL;
     ESP_ERROR_CHECK(esp_io_expander_new_i2c_tca95xx_16bit(i2c_port, ESP_IO_EXPANDER_I2C_TCA9555_ADDRESS_000, &io_expander));
 
@@ -179,4 +199,7 @@ void app_main(void)
 
     // Log state
     esp_io_expander_print_state(io_expander);
+    ESP_ERROR_CHECK(power_pm_set_wake_handler(POWER_GOV_WAKE_EXPANDER, expander_wake, io_expander));
+    power_pm_release(POWER_GOV_ACTIVITY_I2C);
+    power_pm_release(POWER_GOV_ACTIVITY_RENDER);
 }
@@ -0,0 +1,331 @@
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "sdkconfig.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "power_pm.h"
+
+#define WAKE_TASK_STACK 4096
+#define WAKE_TASK_PRIO 5
+
+static const char *TAG = "power_pm";
+
+typedef struct {
+    power_pm_wake_handler_t handler;
+    void *ctx;
+} wake_handler_t;
+
+// Interrupt pin per wake source, -1 where the source is not a pin
+static const int s_wake_gpio[POWER_GOV_WAKE_MAX] = {
+    [POWER_GOV_WAKE_EXPANDER] = CONFIG_POWER_PM_EXPANDER_INT_GPIO,
+    [POWER_GOV_WAKE_TOUCH] = CONFIG_POWER_PM_TOUCH_INT_GPIO,
+    [POWER_GOV_WAKE_TIMER] = -1,
+};
+
+// What the wake task holds while a source's handler runs
+static const power_gov_activity_t s_wake_activity[POWER_GOV_WAKE_MAX] = {
+    [POWER_GOV_WAKE_EXPANDER] = POWER_GOV_ACTIVITY_I2C,
+    [POWER_GOV_WAKE_TOUCH] = POWER_GOV_ACTIVITY_TOUCH,
+    [POWER_GOV_WAKE_TIMER] = POWER_GOV_ACTIVITY_I2C,
+};
+
+static power_gov_t s_gov;
+static bool s_initialized;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t s_cpu_lock;
+#endif
+static esp_timer_handle_t s_linger_timer;
+static int64_t s_arm_deadline_us;
+static bool s_arm_pending;
+static TaskHandle_t s_wake_task;
+static wake_handler_t s_wake_handlers[POWER_GOV_WAKE_MAX];
+#if CONFIG_POWER_PM_TIMER_WAKE_MS > 0
+static esp_timer_handle_t s_wake_timer;
+#endif
+#if CONFIG_POWER_PM_STATS_INTERVAL_S > 0
+static esp_timer_handle_t s_stats_timer;
+#endif
+
+static int64_t pm_now(void *ctx)
+{
+    return esp_timer_get_time();
+}
+
+static void pm_hold(bool held, void *ctx)
+{
+#if CONFIG_PM_ENABLE
+    if (held) {
+        esp_pm_lock_acquire(s_cpu_lock);
+    } else {
+        esp_pm_lock_release(s_cpu_lock);
+    }
+#endif
+}
+
+// Runs under s_lock, where esp_timer can't be called; apply_pending_arm() starts the timer once it is dropped
+static void pm_arm(int64_t deadline_us, void *ctx)
+{
+    s_arm_deadline_us = deadline_us;
+    s_arm_pending = true;
+}
+
+static void apply_pending_arm(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    bool pending = s_arm_pending;
+    int64_t deadline_us = s_arm_deadline_us;
+    s_arm_pending = false;
+    portEXIT_CRITICAL(&s_lock);
+    if (!pending) {
+        return;
+    }
+
+    // Two callers can race here and leave the earlier of their deadlines armed. Deadlines only move later, and
+    // power_gov_timeout() re-arms when it fires early, so that costs one extra timer callback.
+    int64_t delay = deadline_us - esp_timer_get_time();
+    esp_timer_stop(s_linger_timer);
+    esp_timer_start_once(s_linger_timer, delay > 0 ? delay : 0);
+}
+
+static void linger_timer_cb(void *arg)
+{
+    portENTER_CRITICAL(&s_lock);
+    power_gov_timeout(&s_gov);
+    portEXIT_CRITICAL(&s_lock);
+    apply_pending_arm();
+}
+
+static void wake_gpio_isr(void *arg)
+{
+    power_gov_wake_t source = (power_gov_wake_t)(intptr_t)arg;
+    power_pm_note_wake(source);
+    // The interrupt is level triggered and stays asserted until the handler has serviced the device
+    gpio_intr_disable(s_wake_gpio[source]);
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(s_wake_task, BIT(source), eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+#if CONFIG_POWER_PM_TIMER_WAKE_MS > 0
+static void wake_timer_cb(void *arg)
+{
+    power_pm_note_wake(POWER_GOV_WAKE_TIMER);
+    xTaskNotify(s_wake_task, BIT(POWER_GOV_WAKE_TIMER), eSetBits);
+}
+#endif
+
+static void wake_task(void *arg)
+{
+    while (true) {
+        uint32_t sources = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &sources, portMAX_DELAY);
+        for (int i = 0; i < POWER_GOV_WAKE_MAX; i++) {
+            if (!(sources & BIT(i))) {
+                continue;
+            }
+            portENTER_CRITICAL(&s_lock);
+            wake_handler_t wake = s_wake_handlers[i];
+            portEXIT_CRITICAL(&s_lock);
+            // Sources are only armed once they have a handler, so this is just a guard against raising the clock
+            // for nothing
+            if (!wake.handler) {
+                continue;
+            }
+
+            power_pm_acquire(s_wake_activity[i]);
+            wake.handler(i, wake.ctx);
+            power_pm_release(s_wake_activity[i]);
+            if (s_wake_gpio[i] >= 0) {
+                gpio_intr_enable(s_wake_gpio[i]);
+            }
+        }
+    }
+}
+
+#if CONFIG_POWER_PM_STATS_INTERVAL_S > 0
+static void stats_timer_cb(void *arg)
+{
+    power_pm_log_stats();
+}
+#endif
+
+esp_err_t power_pm_init(void)
+{
+    ESP_RETURN_ON_FALSE(!s_initialized, ESP_ERR_INVALID_STATE, TAG, "already initialized");
+
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_POWER_PM_MIN_CPU_FREQ_MHZ,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#endif
+    };
+    ESP_RETURN_ON_ERROR(esp_pm_configure(&pm_config), TAG, "configure pm");
+    ESP_RETURN_ON_ERROR(esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "power_gov", &s_cpu_lock), TAG, "create pm lock");
+#else
+    ESP_LOGW(TAG, "CONFIG_PM_ENABLE is off, only tracking activity");
+#endif
+
+    const esp_timer_create_args_t linger_args = {
+        .callback = linger_timer_cb,
+        .name = "power_linger",
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&linger_args, &s_linger_timer), TAG, "create linger timer");
+
+    power_gov_config_t gov_config = {
+        .now_us = pm_now,
+        .hold = pm_hold,
+        .arm = pm_arm,
+        .linger_us = CONFIG_POWER_PM_LINGER_MS * 1000LL,
+    };
+    power_gov_init(&s_gov, &gov_config);
+
+    ESP_RETURN_ON_FALSE(xTaskCreate(wake_task, "power_wake", WAKE_TASK_STACK, NULL, WAKE_TASK_PRIO, &s_wake_task),
+                        ESP_ERR_NO_MEM, TAG, "create wake task");
+
+    uint64_t wake_pins = 0;
+    for (int i = 0; i < POWER_GOV_WAKE_MAX; i++) {
+        if (s_wake_gpio[i] >= 0) {
+            wake_pins |= BIT64(s_wake_gpio[i]);
+        }
+    }
+    if (wake_pins) {
+        // Both INT outputs are open drain and active low
+        const gpio_config_t pin_config = {
+            .pin_bit_mask = wake_pins,
+            .mode = GPIO_MODE_INPUT,
+            .pull_up_en = GPIO_PULLUP_ENABLE,
+            .intr_type = GPIO_INTR_DISABLE,
+        };
+        ESP_RETURN_ON_ERROR(gpio_config(&pin_config), TAG, "configure wake pins");
+        esp_err_t ret = gpio_install_isr_service(0);
+        ESP_RETURN_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, TAG, "install gpio isr service");
+    }
+
+#if CONFIG_POWER_PM_TIMER_WAKE_MS > 0
+    const esp_timer_create_args_t wake_args = {
+        .callback = wake_timer_cb,
+        .name = "power_wake",
+        .skip_unhandled_events = true,
+    };
+    // Started by power_pm_set_wake_handler()
+    ESP_RETURN_ON_ERROR(esp_timer_create(&wake_args, &s_wake_timer), TAG, "create wake timer");
+#endif
+
+#if CONFIG_POWER_PM_STATS_INTERVAL_S > 0
+    const esp_timer_create_args_t stats_args = {
+        .callback = stats_timer_cb,
+        .name = "power_stats",
+        .skip_unhandled_events = true,
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&stats_args, &s_stats_timer), TAG, "create stats timer");
+    ESP_RETURN_ON_ERROR(esp_timer_start_periodic(s_stats_timer, CONFIG_POWER_PM_STATS_INTERVAL_S * 1000000LL), TAG,
+                        "start stats timer");
+#endif
+
+    s_initialized = true;
+    ESP_LOGI(TAG, "CPU %d-%d MHz, linger %d ms; no light sleep while the RGB panel holds its PLL clock",
+             CONFIG_POWER_PM_MIN_CPU_FREQ_MHZ, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, CONFIG_POWER_PM_LINGER_MS);
+    return ESP_OK;
+}
+
+esp_err_t power_pm_set_wake_handler(power_gov_wake_t source, power_pm_wake_handler_t handler, void *ctx)
+{
+    ESP_RETURN_ON_FALSE(source < POWER_GOV_WAKE_MAX && handler, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(s_initialized, ESP_ERR_INVALID_STATE, TAG, "not initialized");
+#if CONFIG_POWER_PM_TIMER_WAKE_MS == 0
+    ESP_RETURN_ON_FALSE(source != POWER_GOV_WAKE_TIMER, ESP_ERR_NOT_SUPPORTED, TAG, "timer wake is disabled");
+#endif
+
+    portENTER_CRITICAL(&s_lock);
+    s_wake_handlers[source] = (wake_handler_t) {
+        .handler = handler,
+        .ctx = ctx,
+    };
+    portEXIT_CRITICAL(&s_lock);
+
+#if CONFIG_POWER_PM_TIMER_WAKE_MS > 0
+    if (source == POWER_GOV_WAKE_TIMER && !esp_timer_is_active(s_wake_timer)) {
+        ESP_RETURN_ON_ERROR(esp_timer_start_periodic(s_wake_timer, CONFIG_POWER_PM_TIMER_WAKE_MS * 1000LL), TAG,
+                            "start wake timer");
+    }
+#endif
+
+    int gpio = s_wake_gpio[source];
+    if (gpio >= 0) {
+        ESP_RETURN_ON_ERROR(gpio_isr_handler_add(gpio, wake_gpio_isr, (void *)(intptr_t)source), TAG,
+                            "add isr for gpio %d", gpio);
+        ESP_RETURN_ON_ERROR(power_pm_enable_gpio_wake(gpio, false), TAG, "%s wake", power_gov_wake_name(source));
+        ESP_RETURN_ON_ERROR(gpio_intr_enable(gpio), TAG, "enable interrupt on gpio %d", gpio);
+    }
+    return ESP_OK;
+}
+
+void power_pm_acquire(power_gov_activity_t activity)
+{
+    portENTER_CRITICAL(&s_lock);
+    power_gov_acquire(&s_gov, activity);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void power_pm_release(power_gov_activity_t activity)
+{
+    portENTER_CRITICAL(&s_lock);
+    power_gov_release(&s_gov, activity);
+    portEXIT_CRITICAL(&s_lock);
+    apply_pending_arm();
+}
+
+void power_pm_note_wake(power_gov_wake_t source)
+{
+    portENTER_CRITICAL_SAFE(&s_lock);
+    power_gov_note_wake(&s_gov, source);
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+esp_err_t power_pm_enable_gpio_wake(gpio_num_t gpio, bool active_high)
+{
+    ESP_RETURN_ON_ERROR(gpio_wakeup_enable(gpio, active_high ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL), TAG,
+                        "enable wakeup on gpio %d", gpio);
+    ESP_RETURN_ON_ERROR(esp_sleep_enable_gpio_wakeup(), TAG, "enable gpio wakeup");
+    return ESP_OK;
+}
+
+void power_pm_log_stats(void)
+{
+    power_gov_stats_t stats;
+    portENTER_CRITICAL(&s_lock);
+    power_gov_get_stats(&s_gov, &stats);
+    portEXIT_CRITICAL(&s_lock);
+
+    int64_t total_us = 0;
+    for (int i = 0; i < POWER_GOV_STATE_MAX; i++) {
+        total_us += stats.time_us[i];
+    }
+    // Governor states, not power states: with the RGB panel blocking light sleep, "released" is time at the low clock
+    ESP_LOGI(TAG, "governor now %s", power_gov_state_name(stats.state));
+    for (int i = 0; i < POWER_GOV_STATE_MAX; i++) {
+        ESP_LOGI(TAG, "  %-8s %10" PRId64 " ms %3" PRId64 "%% %6" PRIu32 " entries", power_gov_state_name(i),
+                 stats.time_us[i] / 1000, total_us ? stats.time_us[i] * 100 / total_us : 0, stats.entries[i]);
+    }
+    for (int i = 0; i < POWER_GOV_WAKE_MAX; i++) {
+        const power_gov_latency_t *lat = &stats.wake[i];
+        if (lat->count == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "  wake %-8s %6" PRIu32 "x latency min %" PRId64 " avg %" PRId64 " max %" PRId64 " us",
+                 power_gov_wake_name(i), lat->count, lat->min_us, lat->total_us / lat->count, lat->max_us);
+    }
+#if CONFIG_PM_PROFILING
+    esp_pm_dump_locks(stdout);
+#endif
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+#include "power_gov.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Configure esp_pm and start the system activity governor
+ *
+ * The CPU runs at CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ only while an activity is held (plus
+ * CONFIG_POWER_PM_LINGER_MS afterwards). Otherwise esp_pm scales it down to CONFIG_POWER_PM_MIN_CPU_FREQ_MHZ.
+ *
+ * Light sleep is enabled too, but does not happen on this board: the RGB panel runs from the PLL
+ * (LCD_CLK_SRC_DEFAULT) and its driver holds an ESP_PM_NO_LIGHT_SLEEP lock for as long as the panel exists. Released
+ * time in the stats is time at the low clock, not time asleep, and the pins wake the wake task through their
+ * interrupts, not the chip out of sleep.
+ *
+ * Expander and touch interrupt pins from Kconfig are configured as pulled-up inputs; each becomes a wake source once
+ * it has a handler.
+ */
+esp_err_t power_pm_init(void);
+
+/**
+ * @brief Services a wake source. Runs on the power_pm wake task, with the source's activity held.
+ */
+typedef void (*power_pm_wake_handler_t)(power_gov_wake_t source, void *ctx);
+
+/**
+ * @brief Register the handler for a wake source and start waking on it
+ *
+ * The pins are level triggered: the interrupt is masked from when it fires until the handler returns, and the
+ * handler must clear the device's INT output (for the expander, by reading its input port). A pin without a
+ * handler is never armed, since nothing would clear it. Likewise the CONFIG_POWER_PM_TIMER_WAKE_MS timer only
+ * starts with the POWER_GOV_WAKE_TIMER handler; ESP_ERR_NOT_SUPPORTED if that interval is 0.
+ */
+esp_err_t power_pm_set_wake_handler(power_gov_wake_t source, power_pm_wake_handler_t handler, void *ctx);
+
+/**
+ * @brief Hold the CPU at full clock for the duration of an activity. Task context only.
+ */
+void power_pm_acquire(power_gov_activity_t activity);
+
+/**
+ * @brief End an activity started with power_pm_acquire(). Task context only.
+ */
+void power_pm_release(power_gov_activity_t activity);
+
+/**
+ * @brief Record a wake-up event, first thing in whatever noticed it. Safe from a (non-IRAM) ISR.
+ *
+ * The wake sources set up here already call it.
+ */
+void power_pm_note_wake(power_gov_wake_t source);
+
+/**
+ * @brief Use a GPIO level as a light sleep wake source
+ *
+ * Only matters once nothing else blocks light sleep; see power_pm_init().
+ */
+esp_err_t power_pm_enable_gpio_wake(gpio_num_t gpio, bool active_high);
+
+/**
+ * @brief Log time spent in each governor state (locks held or released) and wake-up latencies so far
+ */
+void power_pm_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif